@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "block.h"
+
+#define BENCH_MAX_SIZES 8
+#define BENCH_QUERIES 1000          // Indexed searches per chain size
+#define BENCH_SCANS 20              // Partial-word and facet searches per chain size
+#define BENCH_EDITS 1000            // Updates and deletes per chain size
+
+static const char* title_words[] = {
+    "Senior", "Junior", "Lead", "Staff", "Principal", "Backend", "Frontend", "Data",
+    "Platform", "Mobile", "Security", "Embedded", "Engineer", "Developer", "Analyst", "Architect"};
+static const char* description_words[] = {
+    "build", "maintain", "design", "scale", "distributed", "systems", "services", "pipelines",
+    "reliable", "fast", "secure", "storage", "networking", "compilers", "databases", "kernels",
+    "customers", "teams", "mentor", "review", "deploy", "monitor", "optimize", "test",
+    "cloud", "edge", "payments", "search", "ranking", "analytics", "streaming", "graphics"};
+static const char* companies[] = {"Tech Corp", "Data Inc", "Cloud Ltd", "Edge Labs", "Pay Co", "Search AG"};
+static const char* locations[] = {"Kigali", "Nairobi", "Lagos", "Berlin", "New York", "Tokyo", "Lima"};
+
+#define COUNT_OF(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+// Latency samples for one operation
+typedef struct {
+    double* nanos;
+    int count;
+    int capacity;
+    double total_seconds;           // Wall-clock time for all samples
+} Samples;
+
+static double now_nanos(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static void samples_init(Samples* samples, int capacity) {
+    samples->nanos = (double*)malloc((size_t)capacity * sizeof(double));
+    if (!samples->nanos) {
+        fprintf(stderr, "Error: Memory allocation failed for benchmark samples.\n");
+        exit(1);
+    }
+    samples->count = 0;
+    samples->capacity = capacity;
+    samples->total_seconds = 0;
+}
+
+static void samples_add(Samples* samples, double nanos) {
+    if (samples->count < samples->capacity) {
+        samples->nanos[samples->count++] = nanos;
+    }
+    samples->total_seconds += nanos / 1e9;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Value at fraction (0..1] of the sorted samples
+static double percentile(const Samples* samples, double fraction) {
+    if (samples->count == 0) {
+        return 0;
+    }
+    int rank = (int)(fraction * samples->count + 0.5) - 1;
+    if (rank < 0) {
+        rank = 0;
+    }
+    return samples->nanos[rank < samples->count ? rank : samples->count - 1];
+}
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // Kilobytes on Linux
+}
+
+// Print one result row and append it to the machine-readable output
+static void report(FILE* results, int size, const char* operation, Samples* samples) {
+    qsort(samples->nanos, (size_t)samples->count, sizeof(double), compare_doubles);
+    double rate = samples->total_seconds > 0 ? samples->count / samples->total_seconds : 0;
+    double p50 = percentile(samples, 0.50) / 1e3, p90 = percentile(samples, 0.90) / 1e3;
+    double p99 = percentile(samples, 0.99) / 1e3, max = percentile(samples, 1.0) / 1e3;
+    long rss = peak_rss_kb();
+
+    printf("%-9d %-20s %9d %14.0f %11.2f %11.2f %11.2f %12.2f %10ld\n", size, operation, samples->count, rate, p50,
+           p90, p99, max, rss);
+    if (results != NULL) {
+        fprintf(results,
+                "{\"size\":%d,\"op\":\"%s\",\"ops\":%d,\"ops_per_sec\":%.1f,\"p50_us\":%.3f,\"p90_us\":%.3f,"
+                "\"p99_us\":%.3f,\"max_us\":%.3f,\"peak_rss_kb\":%ld}\n",
+                size, operation, samples->count, rate, p50, p90, p99, max, rss);
+    }
+    samples->count = 0;
+    samples->total_seconds = 0;
+}
+
+// Fill in a deterministic synthetic job
+static void make_job(Job* job, int n, unsigned int* seed) {
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    int value = n;
+    for (int i = JOB_ID_LENGTH - 2; i >= 0; i--) {
+        job->id[i] = digits[value % 36];
+        value /= 36;
+    }
+    job->id[JOB_ID_LENGTH - 1] = '\0';
+    snprintf(job->title, TITLE_LENGTH, "%s %s %s", title_words[rand_r(seed) % 5],
+             title_words[5 + rand_r(seed) % 7], title_words[12 + rand_r(seed) % 4]);
+    snprintf(job->company, COMPANY_LENGTH, "%s", companies[rand_r(seed) % COUNT_OF(companies)]);
+    snprintf(job->location, LOCATION_LENGTH, "%s", locations[rand_r(seed) % COUNT_OF(locations)]);
+    size_t length = 0;
+    for (int w = 0; w < 12; w++) {
+        length += (size_t)snprintf(job->description + length, DESCRIPTION_LENGTH - length, "%s%s", w ? " " : "",
+                                   description_words[rand_r(seed) % COUNT_OF(description_words)]);
+    }
+}
+
+// Time every chain operation on a synthetic chain of size jobs
+static void bench_size(int size, FILE* results) {
+    Blockchain chain;
+    Samples samples;
+    unsigned int seed = (unsigned int)size;
+    Job job;
+    double start;
+
+    initialize_blockchain(&chain);
+    samples_init(&samples, size > BENCH_QUERIES ? size : BENCH_QUERIES);
+
+    // create_block and add_block, timed separately
+    Block** pending = (Block**)malloc((size_t)size * sizeof(Block*));
+    if (!pending) {
+        fprintf(stderr, "Error: Memory allocation failed for benchmark blocks.\n");
+        exit(1);
+    }
+    unsigned char zeros[DIGEST_LENGTH] = {0};
+    for (int i = 0; i < size; i++) {
+        make_job(&job, i, &seed);
+        start = now_nanos();
+        pending[i] = create_block(job, zeros); // add_block relinks to the tail
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "create_block", &samples);
+    for (int i = 0; i < size; i++) {
+        start = now_nanos();
+        add_block(&chain, pending[i]);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "add_block", &samples);
+    free(pending);
+
+    // Full verification of the freshly built chain
+    start = now_nanos();
+    verify_chain(&chain, VERIFY_FULL, 0, NULL);
+    samples_add(&samples, now_nanos() - start);
+    report(results, size, "verify_full", &samples);
+
+    // Searches answered by the keyword index (the first one builds it)
+    PostingList found = {NULL, 0, 0};
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        char query[64];
+        snprintf(query, sizeof(query), "%s %s", title_words[5 + rand_r(&seed) % 7],
+                 description_words[rand_r(&seed) % COUNT_OF(description_words)]);
+        start = now_nanos();
+        search_jobs(&chain, query, QUERY_ALL, &found);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "search_indexed", &samples);
+
+    // Partial words merge the postings of every term containing them
+    for (int i = 0; i < BENCH_SCANS; i++) {
+        char query[64];
+        snprintf(query, sizeof(query), "%.4s", description_words[rand_r(&seed) % COUNT_OF(description_words)]);
+        start = now_nanos();
+        search_jobs(&chain, query, QUERY_ALL, &found);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "search_partial", &samples);
+
+    // Company/location facets, alone and narrowing a keyword query
+    for (int i = 0; i < BENCH_SCANS; i++) {
+        const char* company = companies[rand_r(&seed) % COUNT_OF(companies)];
+        const char* location = locations[rand_r(&seed) % COUNT_OF(locations)];
+        start = now_nanos();
+        filter_jobs(&chain, NULL, QUERY_ALL, company, location, &found);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "filter_facets", &samples);
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        const char* company = companies[rand_r(&seed) % COUNT_OF(companies)];
+        start = now_nanos();
+        filter_jobs(&chain, title_words[5 + rand_r(&seed) % 7], QUERY_ALL, company, NULL, &found);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "filter_facet_keyword", &samples);
+    posting_list_free(&found);
+
+    // Updates and deletes at random positions (update_job is modify_job without the prompts)
+    for (int i = 0; i < BENCH_EDITS; i++) {
+        make_job(&job, rand_r(&seed) % size, &seed);
+        start = now_nanos();
+        update_job(&chain, job.id, &job);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "update_job", &samples);
+    for (int i = 0; i < BENCH_EDITS; i++) {
+        make_job(&job, rand_r(&seed) % size, &seed);
+        start = now_nanos();
+        delete_job(&chain, job.id);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "delete_job", &samples);
+
+    // The first incremental check pays for the deferred re-hash of every edit
+    start = now_nanos();
+    verify_integrity(&chain);
+    samples_add(&samples, now_nanos() - start);
+    report(results, size, "verify_after_edits", &samples);
+    for (int i = 0; i < BENCH_EDITS; i++) {
+        make_job(&job, size + i, &seed);
+        add_block(&chain, create_block(job, chain.tail->hash));
+        start = now_nanos();
+        verify_integrity(&chain);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "verify_incremental", &samples);
+
+    // Merkle tree: the first root pays for every leaf, proofs then cost O(log n)
+    unsigned char root[MERKLE_HASH_LENGTH];
+    MerkleProof proof;
+    merkle_free(&chain.merkle); // Rebuild from scratch, as after a bulk load
+    start = now_nanos();
+    merkle_root_hash(&chain, root);
+    samples_add(&samples, now_nanos() - start);
+    report(results, size, "merkle_build", &samples);
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        make_job(&job, rand_r(&seed) % size, &seed);
+        start = now_nanos();
+        prove_job(&chain, job.id, &proof, root);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "prove_job", &samples);
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        const Block* block = chain.blocks[rand_r(&seed) % chain.next_index];
+        merkle_prove(&chain.merkle, (size_t)block->index, &proof);
+        start = now_nanos();
+        merkle_verify_proof(block->hash, &proof, root);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "verify_proof", &samples);
+    for (int i = 0; i < BENCH_SCANS; i++) {
+        int begin = rand_r(&seed) % chain.next_index;
+        int end = begin + 1000 < chain.next_index ? begin + 1000 : chain.next_index;
+        start = now_nanos();
+        verify_block_range(&chain, begin, end, root);
+        samples_add(&samples, now_nanos() - start);
+    }
+    report(results, size, "verify_range_1000", &samples);
+
+    free(samples.nanos);
+    free_blockchain(&chain);
+}
+
+// Parse a comma-separated list of chain sizes
+static int parse_sizes(const char* list, int sizes[BENCH_MAX_SIZES]) {
+    int count = 0;
+    const char* cursor = list;
+    while (*cursor && count < BENCH_MAX_SIZES) {
+        char* end;
+        long size = strtol(cursor, &end, 10);
+        if (end == cursor || size < 1) {
+            return 0;
+        }
+        sizes[count++] = (int)size;
+        cursor = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    int sizes[BENCH_MAX_SIZES] = {10000, 100000, 1000000};
+    int size_count = 3;
+    const char* output = "bench_results.jsonl";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            size_count = parse_sizes(argv[++i], sizes);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            size_count = 0;
+            break;
+        }
+    }
+    if (size_count == 0) {
+        printf("Usage: %s [--sizes 10000,100000,1000000] [--output bench_results.jsonl]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* results = fopen(output, "w");
+    if (results == NULL) {
+        fprintf(stderr, "Error: Unable to open results file '%s'.\n", output);
+        return 1;
+    }
+    printf("%-9s %-20s %9s %14s %11s %11s %11s %12s %10s\n", "jobs", "operation", "ops", "ops/sec", "p50 (us)",
+           "p90 (us)", "p99 (us)", "max (us)", "RSS (KB)");
+    for (int i = 0; i < size_count; i++) {
+        bench_size(sizes[i], results);
+    }
+    fclose(results);
+    release_block_storage();
+    printf("Results written to '%s'.\n", output);
+    return 0;
+}
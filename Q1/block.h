@@ -1,7 +1,13 @@
 #ifndef BLOCK_H
 #define BLOCK_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
+#include "job_index.h"
+#include "job_dictionary.h"
+#include "merkle.h"
+#include "metrics.h"
 
 #define HASH_LENGTH 65
 #define DESCRIPTION_LENGTH 500
@@ -10,6 +16,7 @@
 #define LOCATION_LENGTH 100
 #define JOB_ID_LENGTH 6
 #define HASH_SIZE 64 // SHA-256 produces a 64-character hash
+#define DIGEST_LENGTH 32 // Raw SHA-256 digest size in bytes
 
 typedef struct {
     char id[JOB_ID_LENGTH];         // Unique identifier for the job
@@ -19,25 +26,128 @@ typedef struct {
     char description[DESCRIPTION_LENGTH]; // Job description
 } Job;
 
+// Cold job text, kept apart from the block header so chain walks stay in cache
+// (company and location are interned; the block holds their codes)
+typedef struct {
+    char title[TITLE_LENGTH];       // Job title
+    char description[DESCRIPTION_LENGTH]; // Job description
+} JobText;
+
+// Hot block header: everything integrity checks and ID lookups touch
 typedef struct Block {
     int index;                      // Position of the block in the chain
     time_t timestamp;               // Time when the block was created
-    Job job;                        // Job data stored in this block
-    char previous_hash[HASH_LENGTH]; // Hash of the previous block
-    char hash[HASH_LENGTH];         // Hash of this block
+    char id[JOB_ID_LENGTH];         // Unique identifier of the job in this block
+    unsigned char previous_hash[DIGEST_LENGTH]; // Raw hash of the previous block (zeros for genesis)
+    unsigned char hash[DIGEST_LENGTH]; // Raw hash of this block
+    JobText* text;                  // Job text stored for this block
     struct Block* next;             // Pointer to the next block
+    struct Block* prev;             // Pointer to the previous block (for O(1) unlinking)
+    uint32_t company;               // Interned company (see job_string)
+    uint32_t location;              // Interned location (see job_string)
+    unsigned char flags;            // BLOCK_* flags
 } Block;
 
+#define BLOCK_TEXT_MAPPED 0x01      // text lives in a chain file mapping, not the text slab
+#define BLOCK_DELETED 0x02          // Tombstone: hidden from lookups, searches and listings until compaction
+
+struct ChainFile;
+struct SHA256state_st;              // OpenSSL's SHA256_CTX
+
+// How much of the chain verify_chain re-hashes
+typedef enum {
+    VERIFY_FULL,                    // Recompute every block's hash
+    VERIFY_INCREMENTAL              // Recompute only blocks added or changed since the last check
+} VerifyMode;
+
+// Outcome of verify_chain
+typedef struct {
+    int intact;                     // 1 if every checked block is valid
+    int first_invalid;              // Index of the first invalid block, or -1
+    int rehashed;                   // Number of blocks whose hash was recomputed
+    double seconds;                 // Wall-clock time spent
+} VerifyResult;
+
+// Chain operations timed by the metrics layer (see metrics.h)
+typedef enum {
+    METRIC_CALCULATE_HASH,
+    METRIC_ADD_BLOCK,
+    METRIC_SEARCH_JOBS,
+    METRIC_VERIFY_CHAIN,
+    CHAIN_METRIC_COUNT
+} ChainMetric;
+
+extern const char* const chain_metric_names[CHAIN_METRIC_COUNT];
+
+// Chain container: tracks both ends of the list and indexes blocks by job ID
+typedef struct {
+    Block* head;                    // First block in the chain
+    Block* tail;                    // Last block in the chain, for O(1) appends
+    int count;                      // Number of live (not deleted) jobs in the chain
+    int tombstones;                 // Deleted blocks still linked into the chain, awaiting compaction
+    int next_index;                 // Index given to the next appended block
+    Block** id_slots;               // Open-addressing table from job ID to block
+    size_t id_capacity;             // Number of slots in id_slots (power of two)
+    size_t id_used;                 // Number of occupied slots
+    int duplicate_ids;              // Blocks appended whose ID was already indexed
+    Block** blocks;                 // Blocks by index, for posting lists
+    uint32_t* company_codes;        // Company code by index (DICTIONARY_NO_CODE once deleted), for facet scans
+    uint32_t* location_codes;       // Location code by index (DICTIONARY_NO_CODE once deleted)
+    int blocks_capacity;            // Allocated entries in blocks and the code columns
+    KeywordIndex keywords;          // Inverted index over job titles and descriptions
+    int ids_ready;                  // 0 while the job ID index still has to be built
+    int keywords_ready;             // 0 while the keyword index still has to be built
+    int verified_upto;              // Blocks below this index passed the last verification
+    int dirty_from;                 // Lowest index whose hash is stale (-1 when all are current)
+    MerkleTree merkle;              // Merkle tree over block hashes, for inclusion proofs and range checks
+    struct ChainFile* file;         // Chain file every change is logged to (NULL if in memory)
+} Blockchain;
+
 // Function prototypes
-Block* create_block(Job job, const char* prev_hash);
-void add_block(Block** blockchain, Block* new_block);
-char* calculate_hash(const Block* block);
-int verify_integrity(const Block* blockchain);
-int search_job(Block *blockchain, const char *keyword);
+void initialize_blockchain(Blockchain* blockchain);
+void free_blockchain(Blockchain* blockchain);
+Block* create_block(Job job, const unsigned char* prev_hash);
+Block* create_mapped_block(const char* job_id, JobText* text, uint32_t company, uint32_t location,
+                           time_t timestamp, const unsigned char* prev_hash, const unsigned char* hash);
+Block* create_hashed_block(const Job* job, const unsigned char* prev_hash, const unsigned char* hash);
+void free_block(Block* block);
+void get_job(const Block* block, Job* job);
+void release_block_storage(void);
+uint32_t intern_job_string(const char* string);
+const char* job_string(uint32_t code);
+void add_block(Blockchain* blockchain, Block* new_block);
+void append_block(Blockchain* blockchain, Block* new_block);
+void rehash_pending(Blockchain* blockchain);
+Block* find_job(Blockchain* blockchain, const char* job_id);
+Block* block_at(const Blockchain* blockchain, int index);
+void reserve_blocks(Blockchain* blockchain, int count);
+void defer_keyword_index(Blockchain* blockchain);
+void replace_block_job(Blockchain* blockchain, Block* block, const Job* job);
+void tombstone_block(Blockchain* blockchain, Block* block);
+int compact_blockchain(Blockchain* blockchain);
+void use_mapped_text(Block* block, JobText* text);
+void calculate_hash(const Block* block, unsigned char digest[DIGEST_LENGTH]);
+void begin_block_hash(struct SHA256state_st* context, const char* title, const char* company,
+                      const char* location, const char* description);
+void finish_block_hash(struct SHA256state_st* context, const unsigned char* prev_hash,
+                       unsigned char digest[DIGEST_LENGTH]);
+void hash_to_hex(const unsigned char digest[DIGEST_LENGTH], char hex[HASH_LENGTH]);
+int verify_integrity(Blockchain* blockchain);
+int verify_chain(Blockchain* blockchain, VerifyMode mode, int threads, VerifyResult* result);
+void sync_merkle_tree(Blockchain* blockchain);
+void merkle_root_hash(Blockchain* blockchain, unsigned char root[MERKLE_HASH_LENGTH]);
+int prove_job(Blockchain* blockchain, const char* job_id, MerkleProof* proof, unsigned char root[MERKLE_HASH_LENGTH]);
+int verify_block_range(Blockchain* blockchain, int begin, int end, const unsigned char* trusted_root);
+int search_job(Blockchain* blockchain, const char* keyword);
+int block_contains(const Block* block, const char* needle, size_t length);
+int search_jobs(Blockchain* blockchain, const char* query, QueryMode mode, PostingList* results);
+int filter_jobs(Blockchain* blockchain, const char* query, QueryMode mode, const char* company,
+                const char* location, PostingList* results);
 void print_menu();
-void list_jobs(const Block* blockchain);
-int modify_job(Block* blockchain, const char* job_id);
-int delete_job(Block** blockchain, const char* job_id);
+void list_jobs(Blockchain* blockchain);
+int update_job(Blockchain* blockchain, const char* job_id, const Job* job);
+int modify_job(Blockchain* blockchain, const char* job_id);
+int delete_job(Blockchain* blockchain, const char* job_id);
 void get_job_details(Job *job);
 
 #endif
@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "chain_file.h"
+
+_Static_assert(sizeof(ChainFileHeader) == 64, "chain file header must stay 64 bytes");
+_Static_assert(sizeof(ChainRecord) % 8 == 0, "chain records must stay 8-byte aligned");
+
+// Write the whole buffer at the current end of the file
+static int write_fully(int fd, const void* data, size_t size) {
+    const char* cursor = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0) {
+            return -1;
+        }
+        cursor += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+// Flush a directory entry change (a rename) in the directory holding path
+static int sync_directory(const char* path) {
+    const char* slash = strrchr(path, '/');
+    char* directory = slash == NULL ? strdup(".") : strndup(path, slash == path ? 1 : (size_t)(slash - path));
+    if (!directory) {
+        fprintf(stderr, "Error: Memory allocation failed for chain file directory.\n");
+        exit(1);
+    }
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    free(directory);
+    int failed = fd < 0 || fsync(fd) != 0;
+    if (fd >= 0) {
+        close(fd);
+    }
+    return failed ? -1 : 0;
+}
+
+// Stop logging after a failed write or fsync until the file is rewritten from memory
+// A partial record is cut off so the log never holds a torn record in the middle.
+static void mark_stale(ChainFile* file) {
+    off_t valid_size = (off_t)(sizeof(ChainFileHeader) + file->records * sizeof(ChainRecord));
+    if (ftruncate(file->fd, valid_size) != 0) {
+        fprintf(stderr, "Error: Unable to drop a partial record from chain file '%s'.\n", file->path);
+    }
+    fprintf(stderr, "Error: Chain file '%s' is behind the directory; later changes are kept in memory "
+                    "until it is rewritten.\n", file->path);
+    file->stale = 1;
+}
+
+// Grow a zero-filled code table so that entry index exists
+static void reserve_codes(uint32_t** table, size_t* capacity, size_t index) {
+    if (index < *capacity) {
+        return;
+    }
+    size_t new_capacity = *capacity ? *capacity : 64;
+    while (new_capacity <= index) {
+        new_capacity *= 2;
+    }
+    uint32_t* codes = (uint32_t*)realloc(*table, new_capacity * sizeof(uint32_t));
+    if (!codes) {
+        fprintf(stderr, "Error: Memory allocation failed for chain file string codes.\n");
+        exit(1);
+    }
+    memset(codes + *capacity, 0, (new_capacity - *capacity) * sizeof(uint32_t));
+    *table = codes;
+    *capacity = new_capacity;
+}
+
+// Record that file code file_code names dictionary code code
+static void map_string(ChainFile* file, uint32_t file_code, uint32_t code) {
+    reserve_codes(&file->dictionary_codes, &file->dictionary_codes_capacity, file_code);
+    reserve_codes(&file->file_codes, &file->file_codes_capacity, code);
+    file->dictionary_codes[file_code] = code;
+    file->file_codes[code] = file_code + 1;
+    if (file_code >= file->strings) {
+        file->strings = file_code + 1;
+    }
+}
+
+// Translate a file code from a record into a dictionary code
+static uint32_t dictionary_code(const ChainFile* file, uint32_t file_code) {
+    if (file_code < file->strings) {
+        return file->dictionary_codes[file_code];
+    }
+    return intern_job_string(""); // Damaged record: treat the value as empty
+}
+
+// Drop every file code assignment
+static void reset_codes(ChainFile* file) {
+    free(file->file_codes);
+    free(file->dictionary_codes);
+    file->file_codes = NULL;
+    file->file_codes_capacity = 0;
+    file->dictionary_codes = NULL;
+    file->dictionary_codes_capacity = 0;
+    file->strings = 0;
+}
+
+// Apply one mapped record to the chain being rebuilt
+static void replay_record(Blockchain* blockchain, ChainFile* file, const ChainRecord* record) {
+    Block* block;
+    Job job;
+    char string[CHAIN_STRING_LENGTH];
+
+    switch (record->type) {
+        case RECORD_APPEND:
+            // Job text stays in the mapping; only the block header is filled in
+            append_block(blockchain, create_mapped_block(record->id, (JobText*)&record->text,
+                                                      dictionary_code(file, record->company),
+                                                      dictionary_code(file, record->location),
+                                                      (time_t)record->timestamp, record->previous_hash,
+                                                      record->hash));
+            break;
+
+        case RECORD_UPDATE:
+            block = block_at(blockchain, record->index);
+            if (block != NULL) {
+                memcpy(job.id, record->id, JOB_ID_LENGTH);
+                memcpy(job.title, record->text.title, TITLE_LENGTH);
+                snprintf(job.company, COMPANY_LENGTH, "%s", job_string(dictionary_code(file, record->company)));
+                snprintf(job.location, LOCATION_LENGTH, "%s", job_string(dictionary_code(file, record->location)));
+                memcpy(job.description, record->text.description, DESCRIPTION_LENGTH);
+                replace_block_job(blockchain, block, &job);
+            }
+            break;
+
+        case RECORD_DELETE:
+            block = block_at(blockchain, record->index);
+            if (block != NULL) {
+                tombstone_block(blockchain, block);
+            }
+            break;
+
+        case RECORD_STRING:
+            if (record->index >= 0) {
+                memcpy(string, record->string, CHAIN_STRING_LENGTH);
+                string[CHAIN_STRING_LENGTH - 1] = '\0';
+                map_string(file, (uint32_t)record->index, intern_job_string(string));
+            }
+            break;
+    }
+}
+
+// Function to open (or create) a chain file and load its blocks into an empty blockchain
+// Records are mapped and used in place, so the file must stay open while the
+// blockchain is in use; close it only after free_blockchain. Later changes to
+// the blockchain are appended to the file. Returns 0 on success, -1 on error.
+int chain_file_open(ChainFile* file, const char* path, Blockchain* blockchain) {
+    file->map = NULL;
+    file->map_size = 0;
+    file->records = 0;
+    file->unsynced = 0;
+    file->stale = 0;
+    file->strings = 0;
+    file->file_codes = NULL;
+    file->file_codes_capacity = 0;
+    file->dictionary_codes = NULL;
+    file->dictionary_codes_capacity = 0;
+    file->path = strdup(path);
+    if (!file->path) {
+        fprintf(stderr, "Error: Memory allocation failed for chain file path.\n");
+        exit(1);
+    }
+    file->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (file->fd < 0) {
+        fprintf(stderr, "Error: Unable to open chain file '%s'.\n", path);
+        free(file->path);
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(file->fd, &info) != 0) {
+        fprintf(stderr, "Error: Unable to read chain file '%s'.\n", path);
+        chain_file_close(file);
+        return -1;
+    }
+
+    if (info.st_size == 0) {
+        ChainFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CHAIN_FILE_MAGIC, sizeof(header.magic));
+        header.version = CHAIN_FILE_VERSION;
+        header.record_size = sizeof(ChainRecord);
+        if (write_fully(file->fd, &header, sizeof(header)) != 0 || fsync(file->fd) != 0) {
+            fprintf(stderr, "Error: Unable to initialize chain file '%s'.\n", path);
+            chain_file_close(file);
+            return -1;
+        }
+        blockchain->file = file;
+        return 0;
+    }
+
+    // Read-only mapping: loaded jobs point into it, and editing one moves its text
+    // into memory first, so the mapped records are never written
+    file->map_size = (size_t)info.st_size;
+    file->map = mmap(NULL, file->map_size, PROT_READ, MAP_SHARED, file->fd, 0);
+    if (file->map == MAP_FAILED) {
+        fprintf(stderr, "Error: Unable to map chain file '%s'.\n", path);
+        file->map = NULL;
+        chain_file_close(file);
+        return -1;
+    }
+
+    const ChainFileHeader* header = (const ChainFileHeader*)file->map;
+    if (file->map_size < sizeof(ChainFileHeader) ||
+        memcmp(header->magic, CHAIN_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CHAIN_FILE_VERSION || header->record_size != sizeof(ChainRecord)) {
+        fprintf(stderr, "Error: '%s' is not a compatible chain file.\n", path);
+        chain_file_close(file);
+        return -1;
+    }
+
+    // A torn record at the end (crash mid-write) is ignored and overwritten
+    file->records = (file->map_size - sizeof(ChainFileHeader)) / sizeof(ChainRecord);
+    off_t valid_size = (off_t)(sizeof(ChainFileHeader) + file->records * sizeof(ChainRecord));
+    if (valid_size != info.st_size && ftruncate(file->fd, valid_size) != 0) {
+        fprintf(stderr, "Error: Unable to repair chain file '%s'.\n", path);
+        chain_file_close(file);
+        return -1;
+    }
+
+    const ChainRecord* records = (const ChainRecord*)((const char*)file->map + sizeof(ChainFileHeader));
+    reserve_blocks(blockchain, (int)file->records);
+    // Both indexes are built on first use instead of at startup
+    blockchain->ids_ready = 0;
+    blockchain->keywords_ready = 0;
+    for (size_t i = 0; i < file->records; i++) {
+        replay_record(blockchain, file, &records[i]);
+    }
+    blockchain->file = file;
+    return 0;
+}
+
+// Get the file code for a dictionary code, filling in a STRING record (and
+// returning 1 in *added) the first time the value is written to this file
+static uint32_t file_code(ChainFile* file, uint32_t code, ChainRecord* string_record, int* added) {
+    *added = 0;
+    if (code < file->file_codes_capacity && file->file_codes[code] != 0) {
+        return file->file_codes[code] - 1;
+    }
+    uint32_t assigned = file->strings;
+    map_string(file, assigned, code);
+    memset(string_record, 0, sizeof(*string_record));
+    string_record->type = RECORD_STRING;
+    string_record->index = (int32_t)assigned;
+    snprintf(string_record->string, CHAIN_STRING_LENGTH, "%s", job_string(code));
+    *added = 1;
+    return assigned;
+}
+
+// Describe a change to block as log records: any new STRING records, then the
+// block's own record. Returns the number of records filled in (at most 3).
+static int fill_records(ChainFile* file, ChainRecord* records, RecordType type, const Block* block) {
+    int count = 0;
+    int added;
+    uint32_t company = 0, location = 0;
+    if (type != RECORD_DELETE) {
+        company = file_code(file, block->company, &records[count], &added);
+        count += added;
+        location = file_code(file, block->location, &records[count], &added);
+        count += added;
+    }
+
+    ChainRecord* record = &records[count++];
+    memset(record, 0, sizeof(*record));
+    record->type = type;
+    record->index = block->index;
+    record->timestamp = (int64_t)block->timestamp;
+    memcpy(record->id, block->id, JOB_ID_LENGTH);
+    memcpy(record->previous_hash, block->previous_hash, DIGEST_LENGTH);
+    memcpy(record->hash, block->hash, DIGEST_LENGTH);
+    if (type != RECORD_DELETE) {
+        record->company = company;
+        record->location = location;
+        record->text = *block->text;
+    }
+    return count;
+}
+
+// Function to append a record describing a change to block
+// Records are written through immediately and fsync'd every
+// CHAIN_FILE_SYNC_RECORDS records. After a failed write or fsync the file is
+// stale: nothing more is logged, so it never holds a change without the ones
+// before it, until chain_file_recover or a compaction rewrites it. Returns 0 on
+// success, -1 on error.
+int chain_file_log(ChainFile* file, RecordType type, const Block* block) {
+    ChainRecord records[3];
+    if (file->stale) {
+        return -1;
+    }
+    int count = fill_records(file, records, type, block);
+
+    if (write_fully(file->fd, records, count * sizeof(ChainRecord)) != 0) {
+        fprintf(stderr, "Error: Unable to write to chain file '%s'.\n", file->path);
+        mark_stale(file);
+        return -1;
+    }
+    file->records += count;
+    file->unsynced += count;
+    if (file->unsynced >= CHAIN_FILE_SYNC_RECORDS) {
+        return chain_file_sync(file);
+    }
+    return 0;
+}
+
+// Function to flush every written record to stable storage
+int chain_file_sync(ChainFile* file) {
+    if (file->unsynced == 0) {
+        return 0;
+    }
+    if (fsync(file->fd) != 0) {
+        fprintf(stderr, "Error: Unable to sync chain file '%s'.\n", file->path);
+        mark_stale(file); // The kernel may have dropped the unsynced records
+        return -1;
+    }
+    file->unsynced = 0;
+    return 0;
+}
+
+// Function to replace the log with one APPEND record per block, in chain order
+// (preceded by the STRING records they use, and followed by a DELETE record for
+// a tombstone)
+// Used after compaction renumbers the chain, and to bring a stale file up to
+// date. The new log is written next to the old one, renamed over it and the
+// rename is flushed to the directory; every block's text is then pointed into
+// the new mapping, which also returns edited jobs' text to the slab. Returns 0
+// on success, -1 on error (the old file is left in place).
+int chain_file_rewrite(ChainFile* file, Blockchain* blockchain) {
+    size_t path_length = strlen(file->path);
+    char* temp_path = (char*)malloc(path_length + sizeof(".compact"));
+    ChainRecord* batch = (ChainRecord*)malloc(CHAIN_FILE_SYNC_RECORDS * sizeof(ChainRecord));
+    if (!temp_path || !batch) {
+        fprintf(stderr, "Error: Memory allocation failed for chain file rewrite.\n");
+        exit(1);
+    }
+    memcpy(temp_path, file->path, path_length);
+    memcpy(temp_path + path_length, ".compact", sizeof(".compact"));
+
+    int fd = open(temp_path, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    ChainFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHAIN_FILE_MAGIC, sizeof(header.magic));
+    header.version = CHAIN_FILE_VERSION;
+    header.record_size = sizeof(ChainRecord);
+    int failed = fd < 0 || write_fully(fd, &header, sizeof(header)) != 0;
+
+    // The new file assigns its own string codes; keep the old ones until it is in place
+    ChainFile old_codes = *file;
+    file->file_codes = NULL;
+    file->file_codes_capacity = 0;
+    file->dictionary_codes = NULL;
+    file->dictionary_codes_capacity = 0;
+    file->strings = 0;
+
+    // Records are written in batches rather than one write per block
+    size_t records = 0;
+    int batched = 0;
+    for (const Block* current = blockchain->head; current != NULL && !failed; current = current->next) {
+        batched += fill_records(file, &batch[batched], RECORD_APPEND, current);
+        if (current->flags & BLOCK_DELETED) {
+            batched += fill_records(file, &batch[batched], RECORD_DELETE, current);
+        }
+        if (batched + 4 > CHAIN_FILE_SYNC_RECORDS || current->next == NULL) {
+            failed = write_fully(fd, batch, batched * sizeof(ChainRecord)) != 0;
+            records += batched;
+            batched = 0;
+        }
+    }
+    free(batch);
+    if (failed || fsync(fd) != 0 || rename(temp_path, file->path) != 0) {
+        fprintf(stderr, "Error: Unable to rewrite chain file '%s'.\n", file->path);
+        if (fd >= 0) {
+            close(fd);
+            unlink(temp_path);
+        }
+        free(temp_path);
+        reset_codes(file);
+        file->file_codes = old_codes.file_codes;
+        file->file_codes_capacity = old_codes.file_codes_capacity;
+        file->dictionary_codes = old_codes.dictionary_codes;
+        file->dictionary_codes_capacity = old_codes.dictionary_codes_capacity;
+        file->strings = old_codes.strings;
+        return -1;
+    }
+    free(temp_path);
+    free(old_codes.file_codes);
+    free(old_codes.dictionary_codes);
+    if (sync_directory(file->path) != 0) {
+        fprintf(stderr, "Error: Unable to sync the directory of chain file '%s'; a crash could restore the old file.\n",
+                file->path);
+    }
+
+    // Later records go to the new file; the old inode lives on while it is mapped
+    close(file->fd);
+    file->fd = fd;
+    file->records = records;
+    file->unsynced = 0;
+    file->stale = 0;
+    size_t map_size = sizeof(ChainFileHeader) + records * sizeof(ChainRecord);
+    void* map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        return 0; // Blocks keep pointing into the old mapping
+    }
+    ChainRecord* mapped = (ChainRecord*)((char*)map + sizeof(ChainFileHeader));
+    size_t i = 0;
+    for (Block* current = blockchain->head; current != NULL; current = current->next, i++) {
+        while (mapped[i].type != RECORD_APPEND) {
+            i++; // STRING and DELETE records
+        }
+        use_mapped_text(current, &mapped[i].text);
+    }
+    if (file->map != NULL) {
+        munmap(file->map, file->map_size);
+    }
+    file->map = map;
+    file->map_size = map_size;
+    return 0;
+}
+
+// Function to bring a stale chain file up to date by rewriting it from the blockchain
+// Call it before freeing the blockchain. Returns 0 if the file now matches the
+// blockchain (or already did), -1 if it is still stale.
+int chain_file_recover(ChainFile* file, Blockchain* blockchain) {
+    if (!file->stale) {
+        return 0;
+    }
+    rehash_pending(blockchain); // Records carry each block's hash
+    return chain_file_rewrite(file, blockchain);
+}
+
+// Function to sync and close a chain file (free the blockchain first)
+void chain_file_close(ChainFile* file) {
+    chain_file_sync(file);
+    if (file->map != NULL) {
+        munmap(file->map, file->map_size);
+        file->map = NULL;
+    }
+    close(file->fd);
+    file->fd = -1;
+    free(file->path);
+    file->path = NULL;
+    reset_codes(file);
+}
@@ -0,0 +1,68 @@
+#ifndef CHAIN_FILE_H
+#define CHAIN_FILE_H
+
+#include <stdint.h>
+#include "block.h"
+
+#define CHAIN_FILE_MAGIC "JOBCHAIN"
+#define CHAIN_FILE_VERSION 4 // 4: companies and locations are stored once, in STRING records
+#define CHAIN_FILE_SYNC_RECORDS 256 // fsync after this many records are written
+#define CHAIN_STRING_LENGTH (COMPANY_LENGTH > LOCATION_LENGTH ? COMPANY_LENGTH : LOCATION_LENGTH)
+
+// Kinds of records in the append-only chain log
+typedef enum {
+    RECORD_APPEND = 1,              // A new block was added to the chain
+    RECORD_UPDATE = 2,              // The job in block `index` was replaced
+    RECORD_DELETE = 3,              // Block `index` was deleted (it stays in the chain as a tombstone)
+    RECORD_STRING = 4               // File code `index` names a company or location string
+} RecordType;
+
+// File header, written once when the file is created
+typedef struct {
+    char magic[8];                  // CHAIN_FILE_MAGIC
+    uint32_t version;               // CHAIN_FILE_VERSION
+    uint32_t record_size;           // sizeof(ChainRecord), guards against layout changes
+    char reserved[48];              // Pads the header to 64 bytes
+} ChainFileHeader;
+
+// Fixed-layout log record; job text is used in place from the mapping on load
+typedef struct {
+    uint32_t type;                  // RecordType
+    int32_t index;                  // Index of the block the record applies to (file code for STRING)
+    int64_t timestamp;              // Block creation time
+    char id[8];                     // Job ID (JOB_ID_LENGTH bytes used)
+    unsigned char previous_hash[DIGEST_LENGTH]; // Raw hash of the previous block
+    unsigned char hash[DIGEST_LENGTH]; // Raw hash of this block
+    uint32_t company;               // File code of the company
+    uint32_t location;              // File code of the location
+    union {
+        JobText text;               // Job text (APPEND, UPDATE)
+        char string[CHAIN_STRING_LENGTH]; // Interned value (STRING)
+    };
+} ChainRecord;
+
+// An open chain file
+typedef struct ChainFile {
+    char* path;                     // Where the file lives, for rewrites
+    int fd;                         // Descriptor records are appended through
+    void* map;                      // Read-only view of the records present at open
+    size_t map_size;                // Bytes mapped
+    size_t records;                 // Records in the file
+    int unsynced;                   // Records written since the last fsync
+    int stale;                      // A write or fsync failed: changes stay in memory until the file is rewritten
+    uint32_t strings;               // STRING records in the file (the next file code)
+    uint32_t* file_codes;           // Dictionary code -> file code + 1 (0 = not in the file yet)
+    size_t file_codes_capacity;
+    uint32_t* dictionary_codes;     // File code -> dictionary code
+    size_t dictionary_codes_capacity;
+} ChainFile;
+
+// Function prototypes
+int chain_file_open(ChainFile* file, const char* path, Blockchain* blockchain);
+int chain_file_log(ChainFile* file, RecordType type, const Block* block);
+int chain_file_sync(ChainFile* file);
+int chain_file_rewrite(ChainFile* file, Blockchain* blockchain);
+int chain_file_recover(ChainFile* file, Blockchain* blockchain);
+void chain_file_close(ChainFile* file);
+
+#endif
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "block.h"
+
+#define VERIFY_MIN_BLOCKS_PER_THREAD 4096 // Smaller ranges are not worth a thread
+#define VERIFY_MAX_THREADS 64
+
+// A contiguous range of block indexes checked by one worker
+typedef struct {
+    Block* const* blocks;           // The chain's index -> block table
+    int begin;                      // First index to check
+    int end;                        // One past the last index to check
+    int first_invalid;              // Lowest invalid index found, or -1
+    int rehashed;                   // Blocks re-hashed by this worker
+} VerifyRange;
+
+// Re-hash every block in a range and check its link to the previous block
+// Tombstoned blocks keep their slot and their place in the chain, so they are
+// re-hashed like any other block.
+static void* verify_range(void* arg) {
+    VerifyRange* range = (VerifyRange*)arg;
+    unsigned char hash[DIGEST_LENGTH];
+
+    for (int i = range->begin; i < range->end; i++) {
+        const Block* block = range->blocks[i];
+        range->rehashed++;
+        calculate_hash(block, hash);
+        if (memcmp(hash, block->hash, DIGEST_LENGTH) != 0 ||
+            (block->prev != NULL && memcmp(block->prev->hash, block->previous_hash, DIGEST_LENGTH) != 0)) {
+            range->first_invalid = i;
+            break; // Later blocks in this range cannot lower the result
+        }
+    }
+    return NULL;
+}
+
+// Pick a worker count for a number of blocks
+static int verify_thread_count(int threads, int blocks) {
+    if (threads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int)online : 1;
+    }
+    int useful = blocks / VERIFY_MIN_BLOCKS_PER_THREAD;
+    if (threads > useful) {
+        threads = useful > 0 ? useful : 1;
+    }
+    return threads < VERIFY_MAX_THREADS ? threads : VERIFY_MAX_THREADS;
+}
+
+// Function to recompute block hashes and check every link of the chain
+// VERIFY_FULL re-hashes every block; VERIFY_INCREMENTAL starts at the checkpoint
+// left by the last successful check, so only blocks appended or changed since
+// then are re-hashed. The index range is split across threads worker threads
+// (0 = one per online CPU). Returns 1 if the chain is intact, 0 otherwise.
+int verify_chain(Blockchain* blockchain, VerifyMode mode, int threads, VerifyResult* result) {
+    struct timespec start, end;
+    METRIC_START(timer);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rehash_pending(blockchain);
+
+    int begin = mode == VERIFY_FULL ? 0 : blockchain->verified_upto;
+    int total = blockchain->next_index - begin;
+    int workers = verify_thread_count(threads, total);
+    VerifyRange ranges[VERIFY_MAX_THREADS];
+    pthread_t handles[VERIFY_MAX_THREADS];
+
+    for (int t = 0; t < workers; t++) {
+        ranges[t].blocks = blockchain->blocks;
+        ranges[t].begin = begin + (int)((long long)total * t / workers);
+        ranges[t].end = begin + (int)((long long)total * (t + 1) / workers);
+        ranges[t].first_invalid = -1;
+        ranges[t].rehashed = 0;
+    }
+    // The calling thread takes the first range itself
+    int started = 1;
+    for (int t = 1; t < workers; t++, started++) {
+        if (pthread_create(&handles[t], NULL, verify_range, &ranges[t]) != 0) {
+            break;
+        }
+    }
+    verify_range(&ranges[0]);
+    for (int t = started; t < workers; t++) {
+        verify_range(&ranges[t]); // Thread creation failed: finish serially
+    }
+    for (int t = 1; t < started; t++) {
+        pthread_join(handles[t], NULL);
+    }
+
+    int first_invalid = -1;
+    int rehashed = 0;
+    for (int t = 0; t < workers; t++) {
+        rehashed += ranges[t].rehashed;
+        if (first_invalid < 0 && ranges[t].first_invalid >= 0) {
+            first_invalid = ranges[t].first_invalid;
+        }
+    }
+    blockchain->verified_upto = first_invalid >= 0 ? first_invalid : blockchain->next_index;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (result != NULL) {
+        result->intact = first_invalid < 0;
+        result->first_invalid = first_invalid;
+        result->rehashed = rehashed;
+        result->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    METRIC_STOP(METRIC_VERIFY_CHAIN, timer);
+    return first_invalid < 0;
+}
+
+// Function to verify the integrity of the blockchain
+int verify_integrity(Blockchain* blockchain) {
+    // Check if blockchain is empty
+    if (blockchain->head == NULL) {
+        printf("Blockchain is empty! No integrity check required.\n");
+        return 1; // Consider it intact since there are no blocks
+    }
+    return verify_chain(blockchain, VERIFY_INCREMENTAL, 0, NULL);
+}
+
+// Function to bring the Merkle tree up to date with the chain's block hashes
+// Only leaves appended or re-hashed since the last sync are recomputed. Bulk
+// loads (append_block) leave the tree stale until the first proof or range check.
+void sync_merkle_tree(Blockchain* blockchain) {
+    MerkleTree* tree = &blockchain->merkle;
+    rehash_pending(blockchain);
+    merkle_resize(tree, (size_t)blockchain->next_index);
+    for (size_t i = tree->valid; i < tree->leaves; i++) {
+        merkle_set_leaf(tree, i, blockchain->blocks[i]->hash);
+    }
+    merkle_update(tree);
+}
+
+// Function to get the current Merkle root of the chain
+void merkle_root_hash(Blockchain* blockchain, unsigned char root[MERKLE_HASH_LENGTH]) {
+    sync_merkle_tree(blockchain);
+    merkle_root(&blockchain->merkle, root);
+}
+
+// Function to build an inclusion proof for a job and the root it proves against
+// Returns 1 on success, 0 if the job is not in the chain.
+int prove_job(Blockchain* blockchain, const char* job_id, MerkleProof* proof, unsigned char root[MERKLE_HASH_LENGTH]) {
+    Block* block = find_job(blockchain, job_id);
+    if (block == NULL) {
+        return 0;
+    }
+    sync_merkle_tree(blockchain);
+    merkle_root(&blockchain->merkle, root);
+    return merkle_prove(&blockchain->merkle, (size_t)block->index, proof);
+}
+
+// Function to verify blocks [begin, end) without reading the rest of the chain
+// Each block in the range is re-hashed from its contents and its link checked;
+// the recomputed hashes then replace the range's leaves, and the resulting root
+// must equal trusted_root (a root published earlier, or the tree's own root if
+// NULL). Blocks outside the range contribute only O(log n) stored subtree hashes.
+// Returns 1 if the range is intact, 0 if not, -1 if the range is invalid.
+int verify_block_range(Blockchain* blockchain, int begin, int end, const unsigned char* trusted_root) {
+    if (begin < 0 || end > blockchain->next_index || begin >= end) {
+        return -1;
+    }
+    unsigned char root[MERKLE_HASH_LENGTH], current_root[MERKLE_HASH_LENGTH];
+    unsigned char (*leaves)[MERKLE_HASH_LENGTH] = malloc((size_t)(end - begin) * MERKLE_HASH_LENGTH);
+    if (!leaves) {
+        fprintf(stderr, "Error: Memory allocation failed for range verification.\n");
+        exit(1);
+    }
+    sync_merkle_tree(blockchain);
+    if (trusted_root == NULL) {
+        merkle_root(&blockchain->merkle, current_root);
+        trusted_root = current_root;
+    }
+
+    int intact = 1;
+    for (int i = begin; i < end && intact; i++) {
+        const Block* block = blockchain->blocks[i];
+        unsigned char hash[DIGEST_LENGTH];
+        calculate_hash(block, hash);
+        if (block->prev != NULL && memcmp(block->prev->hash, block->previous_hash, DIGEST_LENGTH) != 0) {
+            intact = 0;
+        }
+        merkle_leaf_hash(hash, leaves[i - begin]);
+    }
+    if (intact) {
+        merkle_root_with_leaves(&blockchain->merkle, (size_t)begin, (size_t)end,
+                                (const unsigned char (*)[MERKLE_HASH_LENGTH])leaves, root);
+        intact = memcmp(root, trusted_root, MERKLE_HASH_LENGTH) == 0;
+    }
+    free(leaves);
+    return intact;
+}
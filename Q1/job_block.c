@@ -1,153 +1,846 @@
+// The streaming SHA256_* functions are deprecated in OpenSSL 3 but remain the
+// cheapest way to hash small inputs without EVP allocations
+#define OPENSSL_SUPPRESS_DEPRECATED
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <openssl/sha.h>
 #include "block.h"
+#include "slab.h"
+#include "chain_file.h"
+#include "job_render.h"
+
+#define ID_INDEX_MIN_CAPACITY 64
+#define COMPACT_MIN_TOMBSTONES 1024 // Fewer tombstones are not worth a compaction pass
+
+// Block headers and job text live in separate slabs so walking the chain
+// never pulls job text into cache
+static Slab header_slab = {0};
+static Slab text_slab = {0};
+// Companies and locations repeat across many jobs, so every block shares one
+// copy of each distinct value
+static StringDictionary job_strings = {0};
+
+// Names of the chain operations in metrics dumps, by ChainMetric
+const char* const chain_metric_names[CHAIN_METRIC_COUNT] = {
+    "calculate_hash", "add_block", "search_jobs", "verify_chain"
+};
+
+// Hash a job ID (FNV-1a over at most JOB_ID_LENGTH characters)
+static size_t hash_job_id(const char* job_id) {
+    size_t h = 2166136261u;
+    for (int i = 0; i < JOB_ID_LENGTH && job_id[i] != '\0'; i++) {
+        h ^= (unsigned char)job_id[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Find the slot holding job_id, or the empty slot where it would go
+static size_t id_index_probe(const Blockchain* blockchain, const char* job_id) {
+    size_t mask = blockchain->id_capacity - 1;
+    size_t slot = hash_job_id(job_id) & mask;
+    while (blockchain->id_slots[slot] != NULL &&
+           strncmp(blockchain->id_slots[slot]->id, job_id, JOB_ID_LENGTH) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Grow the ID index and re-insert every indexed block
+static void id_index_grow(Blockchain* blockchain) {
+    Block** old_slots = blockchain->id_slots;
+    size_t old_capacity = blockchain->id_capacity;
+    size_t new_capacity = old_capacity ? old_capacity * 2 : ID_INDEX_MIN_CAPACITY;
+
+    blockchain->id_slots = (Block**)calloc(new_capacity, sizeof(Block*));
+    if (!blockchain->id_slots) {
+        fprintf(stderr, "Error: Memory allocation failed for job ID index.\n");
+        exit(1);
+    }
+    blockchain->id_capacity = new_capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i] != NULL) {
+            blockchain->id_slots[id_index_probe(blockchain, old_slots[i]->id)] = old_slots[i];
+        }
+    }
+    free(old_slots);
+}
+
+// Index a block by its job ID; returns 0 if the ID is already indexed
+static int id_index_insert(Blockchain* blockchain, Block* block) {
+    // Keep the load factor at or below 1/2 so probe sequences stay short
+    if ((blockchain->id_used + 1) * 2 > blockchain->id_capacity) {
+        id_index_grow(blockchain);
+    }
+    size_t slot = id_index_probe(blockchain, block->id);
+    if (blockchain->id_slots[slot] != NULL) {
+        return 0;
+    }
+    blockchain->id_slots[slot] = block;
+    blockchain->id_used++;
+    return 1;
+}
+
+// Remove a block from the ID index using backward-shift deletion
+static void id_index_remove(Blockchain* blockchain, const Block* block) {
+    if (blockchain->id_capacity == 0) {
+        return;
+    }
+    size_t mask = blockchain->id_capacity - 1;
+    size_t hole = id_index_probe(blockchain, block->id);
+    if (blockchain->id_slots[hole] != block) {
+        return; // Not the indexed block for this ID
+    }
+
+    // Shift later entries of the probe run back so lookups never stop early
+    size_t next = hole;
+    while (1) {
+        next = (next + 1) & mask;
+        Block* candidate = blockchain->id_slots[next];
+        if (candidate == NULL) {
+            break;
+        }
+        size_t home = hash_job_id(candidate->id) & mask;
+        // Move the candidate only if its home slot is not between the hole and itself
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            blockchain->id_slots[hole] = candidate;
+            hole = next;
+        }
+    }
+    blockchain->id_slots[hole] = NULL;
+    blockchain->id_used--;
+}
+
+// Function to initialize an empty blockchain
+void initialize_blockchain(Blockchain* blockchain) {
+    blockchain->head = NULL;
+    blockchain->tail = NULL;
+    blockchain->count = 0;
+    blockchain->tombstones = 0;
+    blockchain->next_index = 0;
+    blockchain->id_slots = NULL;
+    blockchain->id_capacity = 0;
+    blockchain->id_used = 0;
+    blockchain->duplicate_ids = 0;
+    blockchain->blocks = NULL;
+    blockchain->company_codes = NULL;
+    blockchain->location_codes = NULL;
+    blockchain->blocks_capacity = 0;
+    keyword_index_init(&blockchain->keywords);
+    blockchain->ids_ready = 1;
+    blockchain->keywords_ready = 1;
+    blockchain->verified_upto = 0;
+    blockchain->dirty_from = -1;
+    merkle_init(&blockchain->merkle);
+    blockchain->file = NULL;
+}
+
+// Function to release every block and the index owned by the blockchain
+void free_blockchain(Blockchain* blockchain) {
+    Block* current = blockchain->head;
+    while (current != NULL) {
+        Block* next = current->next;
+        free_block(current);
+        current = next;
+    }
+    free(blockchain->id_slots);
+    free(blockchain->blocks);
+    free(blockchain->company_codes);
+    free(blockchain->location_codes);
+    keyword_index_free(&blockchain->keywords);
+    merkle_free(&blockchain->merkle);
+    initialize_blockchain(blockchain);
+}
+
+// Function to get the code for a company or location, interning it if it is new
+uint32_t intern_job_string(const char* string) {
+    return dictionary_intern(&job_strings, string);
+}
+
+// Function to get the company or location named by a code
+const char* job_string(uint32_t code) {
+    return dictionary_string(&job_strings, code);
+}
+
+// Copy a job's ID and text into a block
+static void set_block_job(Block* block, const Job* job) {
+    memcpy(block->id, job->id, JOB_ID_LENGTH);
+    memcpy(block->text->title, job->title, TITLE_LENGTH);
+    memcpy(block->text->description, job->description, DESCRIPTION_LENGTH);
+    block->company = intern_job_string(job->company);
+    block->location = intern_job_string(job->location);
+}
+
+// Function to copy a block's job back into a Job
+void get_job(const Block* block, Job* job) {
+    memcpy(job->id, block->id, JOB_ID_LENGTH);
+    memcpy(job->title, block->text->title, TITLE_LENGTH);
+    snprintf(job->company, COMPANY_LENGTH, "%s", job_string(block->company));
+    snprintf(job->location, LOCATION_LENGTH, "%s", job_string(block->location));
+    memcpy(job->description, block->text->description, DESCRIPTION_LENGTH);
+}
+
+// Get a zeroed-link block header from the header slab
+static Block* alloc_block_header(void) {
+    if (header_slab.object_size == 0) {
+        slab_init(&header_slab, sizeof(Block));
+        slab_init(&text_slab, sizeof(JobText));
+    }
+    Block* block = (Block*)slab_alloc(&header_slab);
+    block->index = 0; // Will update later when adding to the chain
+    block->next = NULL;
+    block->prev = NULL;
+    block->flags = 0;
+    return block;
+}
 
 // Function to create a new block
-Block* create_block(Job job, const char* prev_hash) {
-    Block* new_block = (Block*)malloc(sizeof(Block));
-    new_block->index = 0; // Will update later when adding to the chain
+// prev_hash is the raw hash of the block this one will follow (NULL for the first block)
+Block* create_block(Job job, const unsigned char* prev_hash) {
+    Block* new_block = alloc_block_header();
+    new_block->text = (JobText*)slab_alloc(&text_slab);
     new_block->timestamp = time(NULL);
-    new_block->job = job;
-    strncpy(new_block->previous_hash, prev_hash, HASH_LENGTH);
-    strncpy(new_block->hash, calculate_hash(new_block), HASH_LENGTH);
-    new_block->next = NULL;
+    set_block_job(new_block, &job);
+    if (prev_hash != NULL) {
+        memcpy(new_block->previous_hash, prev_hash, DIGEST_LENGTH);
+    } else {
+        memset(new_block->previous_hash, 0, DIGEST_LENGTH);
+    }
+    calculate_hash(new_block, new_block->hash);
     return new_block;
 }
 
-// Function to calculate the hash of a block using SHA-256
-char* calculate_hash(const Block* block) {
-    static char hash[HASH_LENGTH];
-    char data[TITLE_LENGTH + COMPANY_LENGTH + LOCATION_LENGTH + DESCRIPTION_LENGTH + HASH_LENGTH];
+// Function to create a block whose hash was already computed (e.g. by a bulk import)
+Block* create_hashed_block(const Job* job, const unsigned char* prev_hash, const unsigned char* hash) {
+    Block* new_block = alloc_block_header();
+    new_block->text = (JobText*)slab_alloc(&text_slab);
+    new_block->timestamp = time(NULL);
+    set_block_job(new_block, job);
+    if (prev_hash != NULL) {
+        memcpy(new_block->previous_hash, prev_hash, DIGEST_LENGTH);
+    } else {
+        memset(new_block->previous_hash, 0, DIGEST_LENGTH);
+    }
+    memcpy(new_block->hash, hash, DIGEST_LENGTH);
+    return new_block;
+}
+
+// Function to create a block around job text that already lives in a chain
+// file mapping; the text is used in place and the stored hash is trusted
+Block* create_mapped_block(const char* job_id, JobText* text, uint32_t company, uint32_t location,
+                           time_t timestamp, const unsigned char* prev_hash, const unsigned char* hash) {
+    Block* block = alloc_block_header();
+    block->text = text;
+    block->company = company;
+    block->location = location;
+    block->flags = BLOCK_TEXT_MAPPED;
+    block->timestamp = timestamp;
+    memcpy(block->id, job_id, JOB_ID_LENGTH);
+    memcpy(block->previous_hash, prev_hash, DIGEST_LENGTH);
+    memcpy(block->hash, hash, DIGEST_LENGTH);
+    return block;
+}
+
+// Function to return a block and its job text to the block storage
+void free_block(Block* block) {
+    if (!(block->flags & BLOCK_TEXT_MAPPED)) {
+        slab_free(&text_slab, block->text);
+    }
+    slab_free(&header_slab, block);
+}
+
+// Function to point a block's text at a mapped chain file record, releasing its own copy
+void use_mapped_text(Block* block, JobText* text) {
+    if (!(block->flags & BLOCK_TEXT_MAPPED)) {
+        slab_free(&text_slab, block->text);
+    }
+    block->text = text;
+    block->flags |= BLOCK_TEXT_MAPPED;
+}
+
+// Function to release all block storage at once (every block becomes invalid)
+void release_block_storage(void) {
+    slab_destroy(&header_slab);
+    slab_destroy(&text_slab);
+    header_slab.object_size = 0;
+    dictionary_free(&job_strings);
+}
+
+// Function to start a block hash by absorbing the job text
+// This covers everything except the previous hash, so it can run ahead of
+// (and in parallel with) linking the block into the chain.
+void begin_block_hash(SHA256_CTX* context, const char* title, const char* company,
+                      const char* location, const char* description) {
+    SHA256_Init(context);
+    SHA256_Update(context, title, strnlen(title, TITLE_LENGTH));
+    SHA256_Update(context, company, strnlen(company, COMPANY_LENGTH));
+    SHA256_Update(context, location, strnlen(location, LOCATION_LENGTH));
+    SHA256_Update(context, description, strnlen(description, DESCRIPTION_LENGTH));
+}
+
+// Function to finish a block hash started by begin_block_hash
+void finish_block_hash(SHA256_CTX* context, const unsigned char* prev_hash, unsigned char digest[DIGEST_LENGTH]) {
+    SHA256_Update(context, prev_hash, DIGEST_LENGTH);
+    SHA256_Final(digest, context);
+}
+
+// Function to calculate the raw SHA-256 hash of a block
+// The job fields and the previous hash are streamed straight into the digest,
+// with no intermediate buffer or shared state, so this is safe to call from
+// several threads at once.
+void calculate_hash(const Block* block, unsigned char digest[DIGEST_LENGTH]) {
+    const JobText* text = block->text;
+    SHA256_CTX context;
+    METRIC_START(start);
+
+    begin_block_hash(&context, text->title, job_string(block->company), job_string(block->location), text->description);
+    finish_block_hash(&context, block->previous_hash, digest);
+    METRIC_STOP(METRIC_CALCULATE_HASH, start);
+}
+
+// Function to hex-encode a raw hash for display
+void hash_to_hex(const unsigned char digest[DIGEST_LENGTH], char hex[HASH_LENGTH]) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < DIGEST_LENGTH; i++) {
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0x0f];
+    }
+    hex[DIGEST_LENGTH * 2] = '\0';
+}
+
+
+// Index a block's title and description under its position
+static void keyword_index_add_block(Blockchain* blockchain, const Block* block) {
+    keyword_index_add(&blockchain->keywords, block->index, block->text->title);
+    keyword_index_add(&blockchain->keywords, block->index, block->text->description);
+}
 
-    snprintf(data, sizeof(data), "%s%s%s%s%s", 
-        block->job.title,         // Access job.title
-        block->job.company,       // Access job.company
-        block->job.location,      // Access job.location
-        block->job.description,   // Access job.description
-        block->previous_hash);        // Access the previous hash
+// Drop a block's title and description from the keyword index
+static void keyword_index_remove_block(Blockchain* blockchain, const Block* block) {
+    keyword_index_remove(&blockchain->keywords, block->index, block->text->title);
+    keyword_index_remove(&blockchain->keywords, block->index, block->text->description);
+}
 
-    unsigned char temp_hash[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)data, strlen(data), temp_hash);
+// Build the keyword index over every block if it was deferred (e.g. after loading a file)
+static void ensure_keyword_index(Blockchain* blockchain) {
+    if (blockchain->keywords_ready) {
+        return;
+    }
+    for (const Block* current = blockchain->head; current != NULL; current = current->next) {
+        if (!(current->flags & BLOCK_DELETED)) {
+            keyword_index_add_block(blockchain, current);
+        }
+    }
+    blockchain->keywords_ready = 1;
+}
 
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(hash + (i * 2), "%02x", temp_hash[i]);
+// Function to drop the keyword index and rebuild it on the next search
+// Bulk loads call this so they do not tokenize every job up front.
+void defer_keyword_index(Blockchain* blockchain) {
+    keyword_index_free(&blockchain->keywords);
+    blockchain->keywords_ready = 0;
+}
+
+// Grow the index -> block table to hold at least count blocks
+static void reserve_block_table(Blockchain* blockchain, int count) {
+    if (count <= blockchain->blocks_capacity) {
+        return;
     }
-    return hash;
+    int capacity = blockchain->blocks_capacity ? blockchain->blocks_capacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    Block** blocks = (Block**)realloc(blockchain->blocks, capacity * sizeof(Block*));
+    uint32_t* companies = (uint32_t*)realloc(blockchain->company_codes, capacity * sizeof(uint32_t));
+    uint32_t* locations = companies ? (uint32_t*)realloc(blockchain->location_codes, capacity * sizeof(uint32_t)) : NULL;
+    if (!blocks || !companies || !locations) {
+        fprintf(stderr, "Error: Memory allocation failed for block table.\n");
+        exit(1);
+    }
+    blockchain->blocks = blocks;
+    blockchain->company_codes = companies;
+    blockchain->location_codes = locations;
+    blockchain->blocks_capacity = capacity;
 }
 
+// Function to pre-size the chain's tables for count more blocks (e.g. before a bulk load)
+void reserve_blocks(Blockchain* blockchain, int count) {
+    reserve_block_table(blockchain, blockchain->next_index + count);
+    if (blockchain->ids_ready) {
+        while ((blockchain->id_used + count) * 2 > blockchain->id_capacity) {
+            id_index_grow(blockchain);
+        }
+    }
+}
+
+// Function to re-hash every block from the lowest modified position onward
+// Edits only record where the chain went stale; this single pass then relinks
+// each later block to its predecessor's new hash.
+void rehash_pending(Blockchain* blockchain) {
+    if (blockchain->dirty_from < 0) {
+        return;
+    }
+    Block* current = NULL;
+    for (int i = blockchain->dirty_from; i < blockchain->next_index && current == NULL; i++) {
+        current = blockchain->blocks[i];
+    }
+    for (; current != NULL; current = current->next) {
+        if (current->prev != NULL) {
+            memcpy(current->previous_hash, current->prev->hash, DIGEST_LENGTH);
+        } else {
+            memset(current->previous_hash, 0, DIGEST_LENGTH);
+        }
+        calculate_hash(current, current->hash);
+    }
+    blockchain->dirty_from = -1;
+}
+
+// Function to add a block to the end of the blockchain
+// Pending re-hashes are applied first so the new block links to the tail's
+// current hash; the Merkle tree then takes the new leaf in O(log n) hashes.
+void add_block(Blockchain* blockchain, Block* new_block) {
+    METRIC_START(start);
+    rehash_pending(blockchain);
+    if (blockchain->tail != NULL && memcmp(new_block->previous_hash, blockchain->tail->hash, DIGEST_LENGTH) != 0) {
+        memcpy(new_block->previous_hash, blockchain->tail->hash, DIGEST_LENGTH);
+        calculate_hash(new_block, new_block->hash);
+    }
+    append_block(blockchain, new_block);
+    sync_merkle_tree(blockchain);
+    METRIC_STOP(METRIC_ADD_BLOCK, start);
+}
 
-// Function to add a block to the blockchain
-void add_block(Block** blockchain, Block* new_block) {
-    Block* current = *blockchain;
-    if (current == NULL) {
-        *blockchain = new_block;
+// Function to link a block at the tail as-is (used when replaying a chain file)
+void append_block(Blockchain* blockchain, Block* new_block) {
+    reserve_block_table(blockchain, blockchain->next_index + 1);
+    new_block->index = blockchain->next_index++;
+    blockchain->blocks[new_block->index] = new_block;
+    blockchain->company_codes[new_block->index] = new_block->company;
+    blockchain->location_codes[new_block->index] = new_block->location;
+    new_block->next = NULL;
+    new_block->prev = blockchain->tail;
+    if (blockchain->tail == NULL) {
+        blockchain->head = new_block;
     } else {
-        while (current->next != NULL) {
-            current = current->next;
+        blockchain->tail->next = new_block;
+    }
+    blockchain->tail = new_block;
+    blockchain->count++;
+
+    if (blockchain->ids_ready && !id_index_insert(blockchain, new_block)) {
+        blockchain->duplicate_ids++; // Lookups keep returning the earliest block
+    }
+    if (blockchain->keywords_ready) {
+        keyword_index_add_block(blockchain, new_block);
+    }
+    if (blockchain->file != NULL) {
+        // A failed write warns and marks the file stale; chain_file_recover rewrites it
+        chain_file_log(blockchain->file, RECORD_APPEND, new_block);
+    }
+}
+
+// Function to get the block at a chain index (NULL if out of range)
+Block* block_at(const Blockchain* blockchain, int index) {
+    if (index < 0 || index >= blockchain->next_index) {
+        return NULL;
+    }
+    return blockchain->blocks[index];
+}
+
+// Build the job ID index over every block if it was deferred (e.g. after loading a file)
+static void ensure_id_index(Blockchain* blockchain) {
+    if (blockchain->ids_ready) {
+        return;
+    }
+    while ((blockchain->id_used + blockchain->count) * 2 > blockchain->id_capacity) {
+        id_index_grow(blockchain);
+    }
+    for (Block* current = blockchain->head; current != NULL; current = current->next) {
+        if (!(current->flags & BLOCK_DELETED) && !id_index_insert(blockchain, current)) {
+            blockchain->duplicate_ids++;
         }
-        current->next = new_block;
     }
+    blockchain->ids_ready = 1;
 }
 
-// Function to verify the integrity of the blockchain
-int verify_integrity(const Block* blockchain) {
-    // Check if blockchain is empty
-    if (blockchain == NULL) {
-        printf("Blockchain is empty! No integrity check required.\n");
-        return 1; // Consider it intact since there are no blocks
+// Function to find the block holding a job by its ID
+Block* find_job(Blockchain* blockchain, const char* job_id) {
+    ensure_id_index(blockchain);
+    if (blockchain->id_capacity == 0) {
+        return NULL;
     }
+    return blockchain->id_slots[id_index_probe(blockchain, job_id)];
+}
 
-    const Block* current = blockchain;
-    while (current != NULL && current->next != NULL) {
-        if (strcmp(current->hash, current->next->previous_hash) != 0) {
-            return 0; // Integrity check failed
+// Re-index the earliest remaining block with this ID after the indexed one leaves
+static void id_index_promote_duplicate(Blockchain* blockchain, const char* job_id) {
+    if (blockchain->duplicate_ids == 0) {
+        return;
+    }
+    for (Block* current = blockchain->head; current != NULL; current = current->next) {
+        if (!(current->flags & BLOCK_DELETED) && strncmp(current->id, job_id, JOB_ID_LENGTH) == 0) {
+            id_index_insert(blockchain, current);
+            blockchain->duplicate_ids--;
+            return;
         }
-        current = current->next;
     }
-    return 1; // Blockchain is intact
 }
 
 // Function to list all job listings
-void list_jobs(const Block* blockchain) {
-    const Block* current = blockchain;
-    if (current == NULL) {
+void list_jobs(Blockchain* blockchain) {
+    if (blockchain->count == 0) {
         printf("No job listings available.\n");
         return;
     }
+    render_jobs(blockchain, NULL, stdout, RENDER_TEXT, 0, 0);
+}
 
-    while (current != NULL) {
-        printf("Job ID: %s\n", current->job.id);
-        printf("Title: %s\n", current->job.title);
-        printf("Company: %s\n", current->job.company);
-        printf("Location: %s\n", current->job.location);
-        printf("Description: %s\n", current->job.description);
-        printf("Timestamp: %s", ctime(&current->timestamp));
-        printf("Hash: %s\n", current->hash);
-        printf("Previous Hash: %s\n", current->previous_hash);
-        printf("--------------------\n");
-        current = current->next;
+// Case-insensitive check whether text contains the first length characters of needle
+static int contains_ignore_case(const char* text, const char* needle, size_t length) {
+    if (length == 0) {
+        return 1;
     }
+    for (; *text; text++) {
+        size_t i = 0;
+        while (i < length && text[i] &&
+               tolower((unsigned char)text[i]) == tolower((unsigned char)needle[i])) {
+            i++;
+        }
+        if (i == length) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
-// Function to search for jobs by keyword
-int search_job(Block* blockchain, const char* keyword) {
-    int found = 0;
-    Block* current = blockchain;
-    while (current != NULL) {
-        if (strstr(current->job.title, keyword) || strstr(current->job.description, keyword)) {
-            printf("Job ID: %s\n", current->job.id);
-            printf("Title: %s\n", current->job.title);
-            printf("Company: %s\n", current->job.company);
-            printf("Location: %s\n", current->job.location);
-            printf("Description: %s\n", current->job.description);
-            printf("Timestamp: %s", ctime(&current->timestamp));
-            printf("Hash: %s\n", current->hash);
-            printf("Previous Hash: %s\n", current->previous_hash);
-            printf("--------------------\n");
-            found = 1;
-        }
-        current = current->next;
+// Function to check whether a job's title or description contains needle, ignoring case
+int block_contains(const Block* block, const char* needle, size_t length) {
+    return contains_ignore_case(block->text->title, needle, length) ||
+           contains_ignore_case(block->text->description, needle, length);
+}
+
+// Scan the chain for jobs containing needle
+static void scan_jobs(const Blockchain* blockchain, const char* needle, size_t length, PostingList* out) {
+    for (const Block* current = blockchain->head; current != NULL; current = current->next) {
+        if (!(current->flags & BLOCK_DELETED) && block_contains(current, needle, length)) {
+            posting_list_append(out, current->index);
+        }
+    }
+}
+
+// Collect the jobs containing a query word, whole or as part of a longer word
+// term is the word lower-cased (and cut to KEYWORD_MAX_LENGTH). Indexed words
+// come from every term that contains it; jobs with a word too long to index
+// are listed under KEYWORD_LONG_TERM and checked directly. Deleted jobs are
+// not filtered out.
+static void match_word(const Blockchain* blockchain, const char* word, size_t length, const char* term, PostingList* out) {
+    out->count = 0;
+    if (length <= KEYWORD_MAX_LENGTH) {
+        keyword_index_containing(&blockchain->keywords, term, out);
+    }
+    const PostingList* long_words = keyword_index_lookup(&blockchain->keywords, KEYWORD_LONG_TERM);
+    if (long_words != NULL) {
+        PostingList scanned = {NULL, 0, 0};
+        for (int i = 0; i < long_words->count; i++) {
+            if (block_contains(blockchain->blocks[long_words->positions[i]], word, length)) {
+                posting_list_append(&scanned, long_words->positions[i]);
+            }
+        }
+        posting_list_union(out, &scanned);
+        posting_list_free(&scanned);
     }
+}
+
+// Function to find the positions of jobs matching a keyword query
+// Each word of the query matches jobs whose title or description contains it,
+// ignoring case, so "Soft" finds "Software" as well as "Soft skills". Words
+// are answered from the inverted index's terms rather than by scanning the
+// chain. Results are combined with AND or OR and returned in chain order. A
+// query without any word (punctuation only) matches its raw text as a
+// substring.
+int search_jobs(Blockchain* blockchain, const char* query, QueryMode mode, PostingList* results) {
+    char term[KEYWORD_MAX_LENGTH + 1];
+    size_t length;
+    const char* cursor = query;
+    int terms = 0;
+    METRIC_START(start);
+
+    ensure_keyword_index(blockchain);
+    results->count = 0;
+    while ((cursor = next_keyword(cursor, term, &length)) != NULL) {
+        PostingList matched = {NULL, 0, 0};
+        match_word(blockchain, cursor - length, length, term, &matched);
+        if (terms++ == 0) {
+            posting_list_free(results); // The first word's matches become the results
+            *results = matched;
+        } else {
+            if (mode == QUERY_ALL) {
+                posting_list_intersect(results, &matched);
+            } else {
+                posting_list_union(results, &matched);
+            }
+            posting_list_free(&matched);
+        }
+
+        if (mode == QUERY_ALL && results->count == 0) {
+            break; // No later term can bring matches back
+        }
+    }
+
+    if (terms == 0) {
+        // Nothing indexable (e.g. punctuation only): match the raw query text
+        scan_jobs(blockchain, query, strlen(query), results);
+    } else if (blockchain->tombstones > 0) {
+        // Posting lists keep deleted blocks until compaction
+        int kept = 0;
+        for (int i = 0; i < results->count; i++) {
+            if (!(blockchain->blocks[results->positions[i]]->flags & BLOCK_DELETED)) {
+                results->positions[kept++] = results->positions[i];
+            }
+        }
+        results->count = kept;
+    }
+    METRIC_STOP(METRIC_SEARCH_JOBS, start);
+    return results->count;
+}
+
+// Function to find jobs by company and/or location, optionally narrowed by a keyword query
+// NULL (or empty) company, location or query means "any". Facets are matched
+// exactly by comparing interned codes: without a query this scans the chain's
+// code columns, with one it filters the keyword results. Results are in chain order.
+int filter_jobs(Blockchain* blockchain, const char* query, QueryMode mode, const char* company,
+                const char* location, PostingList* results) {
+    int match_company = company != NULL && company[0] != '\0';
+    int match_location = location != NULL && location[0] != '\0';
+    uint32_t company_code = match_company ? dictionary_find(&job_strings, company) : DICTIONARY_NO_CODE;
+    uint32_t location_code = match_location ? dictionary_find(&job_strings, location) : DICTIONARY_NO_CODE;
+
+    results->count = 0;
+    if ((match_company && company_code == DICTIONARY_NO_CODE) ||
+        (match_location && location_code == DICTIONARY_NO_CODE)) {
+        return 0; // No job has ever used this value
+    }
+
+    if (query != NULL && query[0] != '\0') {
+        search_jobs(blockchain, query, mode, results);
+        int kept = 0;
+        for (int i = 0; i < results->count; i++) {
+            int position = results->positions[i];
+            if ((!match_company || blockchain->company_codes[position] == company_code) &&
+                (!match_location || blockchain->location_codes[position] == location_code)) {
+                results->positions[kept++] = position;
+            }
+        }
+        results->count = kept;
+        return kept;
+    }
+
+    const uint32_t* companies = blockchain->company_codes;
+    const uint32_t* locations = blockchain->location_codes;
+    for (int i = 0; i < blockchain->next_index; i++) {
+        if (companies[i] == DICTIONARY_NO_CODE) {
+            continue; // Deleted
+        }
+        if ((match_company && companies[i] != company_code) || (match_location && locations[i] != location_code)) {
+            continue;
+        }
+        posting_list_append(results, i);
+    }
+    return results->count;
+}
+
+// Function to search for jobs by keyword
+int search_job(Blockchain* blockchain, const char* keyword) {
+    PostingList results = {NULL, 0, 0};
+    int found = search_jobs(blockchain, keyword, QUERY_ALL, &results) > 0;
+    render_jobs(blockchain, &results, stdout, RENDER_TEXT, 0, 0);
+    posting_list_free(&results);
     if (!found) {
         printf("No jobs found for keyword '%s'.\n", keyword);
     }
     return found;
 }
 
-// Function to modify a job
-int modify_job(Block* blockchain, const char* job_id) {
-    Block* current = blockchain;
-    while (current != NULL) {
-        if (strcmp(current->job.id, job_id) == 0) {
-            printf("Modifying job: %s\n", current->job.title);
-            get_job_details(&current->job);
-            strncpy(current->hash, calculate_hash(current), HASH_LENGTH); // Recalculate the hash
-            return 1; // Modification successful
+// Record that blocks from index onward need re-hashing and re-verification
+static void mark_dirty(Blockchain* blockchain, int index) {
+    if (blockchain->dirty_from < 0 || index < blockchain->dirty_from) {
+        blockchain->dirty_from = index;
+    }
+    if (index < blockchain->verified_upto) {
+        blockchain->verified_upto = index;
+    }
+    merkle_invalidate(&blockchain->merkle, (size_t)index);
+}
+
+// Function to replace a block's job data, keeping the indexes in step
+void replace_block_job(Blockchain* blockchain, Block* block, const Job* job) {
+    int id_changed = strncmp(block->id, job->id, JOB_ID_LENGTH) != 0;
+    if (blockchain->keywords_ready) {
+        keyword_index_remove_block(blockchain, block);
+    }
+    if (block->flags & BLOCK_TEXT_MAPPED) {
+        // Mapped chain file text is read-only: move the job into the text slab first
+        block->text = (JobText*)slab_alloc(&text_slab);
+        block->flags &= ~BLOCK_TEXT_MAPPED;
+    }
+    if (id_changed && blockchain->ids_ready) {
+        char old_id[JOB_ID_LENGTH];
+        memcpy(old_id, block->id, JOB_ID_LENGTH);
+        id_index_remove(blockchain, block);
+        set_block_job(block, job);
+        id_index_promote_duplicate(blockchain, old_id);
+        if (!id_index_insert(blockchain, block)) {
+            blockchain->duplicate_ids++;
         }
-        current = current->next;
+    } else {
+        set_block_job(block, job);
+    }
+    if (blockchain->keywords_ready) {
+        keyword_index_add_block(blockchain, block);
+    }
+    blockchain->company_codes[block->index] = block->company;
+    blockchain->location_codes[block->index] = block->location;
+    mark_dirty(blockchain, block->index); // Hash recomputed by the next rehash_pending
+    if (blockchain->file != NULL) {
+        chain_file_log(blockchain->file, RECORD_UPDATE, block);
     }
-    return 0; // Job not found
 }
 
-// Function to delete a job
-int delete_job(Block** blockchain, const char* job_id) {
-    Block* current = *blockchain;
-    Block* previous = NULL;
+// Function to replace a job's details without prompting
+int update_job(Blockchain* blockchain, const char* job_id, const Job* job) {
+    Block* block = find_job(blockchain, job_id);
+    if (block == NULL) {
+        return 0; // Job not found
+    }
+    replace_block_job(blockchain, block, job);
+    return 1;
+}
+
+// Function to get job details from the user
+void get_job_details(Job *job) {
+    printf("Enter Job ID (e.g., J0001): ");
+    scanf(" %5s", job->id); // Read job ID
+    printf("Enter Job Title: ");
+    scanf(" %[^\n]%*c", job->title); // Reads input with spaces
+    printf("Enter Company: ");
+    scanf(" %[^\n]%*c", job->company);
+    printf("Enter Location: ");
+    scanf(" %[^\n]%*c", job->location);
+    printf("Enter Job Description: ");
+    scanf(" %[^\n]%*c", job->description);
+}
 
+// Function to modify a job
+int modify_job(Blockchain* blockchain, const char* job_id) {
+    Block* block = find_job(blockchain, job_id);
+    if (block == NULL) {
+        return 0; // Job not found
+    }
+    printf("Modifying job: %s\n", block->text->title);
+    Job job;
+    get_job(block, &job); // Fields left unread keep their current values
+    get_job_details(&job);
+    replace_block_job(blockchain, block, &job);
+    return 1; // Modification successful
+}
+
+// Function to mark a block deleted without unlinking it
+// The block keeps its place and hash, so every link (and verification) stays
+// valid; it is only dropped from the ID index. Posting lists keep it until
+// compact_blockchain, and searches and listings skip it.
+void tombstone_block(Blockchain* blockchain, Block* block) {
+    if (block->flags & BLOCK_DELETED) {
+        return;
+    }
+    block->flags |= BLOCK_DELETED;
+    blockchain->count--;
+    blockchain->tombstones++;
+    blockchain->company_codes[block->index] = DICTIONARY_NO_CODE;
+    blockchain->location_codes[block->index] = DICTIONARY_NO_CODE;
+    if (blockchain->ids_ready) {
+        id_index_remove(blockchain, block);
+        id_index_promote_duplicate(blockchain, block->id);
+    }
+    if (blockchain->file != NULL) {
+        chain_file_log(blockchain->file, RECORD_DELETE, block);
+    }
+}
+
+// Function to drop every tombstoned block in one pass
+// Survivors are renumbered, relinked and re-hashed from the first dropped
+// position onward, the keyword index is rebuilt on the next search, and an
+// attached chain file is rewritten to match. Returns the number of blocks dropped.
+int compact_blockchain(Blockchain* blockchain) {
+    if (blockchain->tombstones == 0) {
+        return 0;
+    }
+    int dropped = 0;
+    int survivors = 0;
+    int first_stale = -1;
+    int verified = 0;
+    Block* current = blockchain->head;
     while (current != NULL) {
-        if (strcmp(current->job.id, job_id) == 0) {
-            if (previous == NULL) { // First block
-                *blockchain = current->next;
+        Block* next = current->next;
+        if (current->flags & BLOCK_DELETED) {
+            if (current->prev == NULL) {
+                blockchain->head = next;
             } else {
-                previous->next = current->next;
+                current->prev->next = next;
             }
-            free(current);
-            return 1; // Deletion successful
+            if (next == NULL) {
+                blockchain->tail = current->prev;
+            } else {
+                next->prev = current->prev;
+            }
+            if (first_stale < 0) {
+                first_stale = survivors; // The next survivor links to a new predecessor
+            }
+            free_block(current);
+            dropped++;
+        } else {
+            if (first_stale < 0 && blockchain->dirty_from >= 0 && current->index >= blockchain->dirty_from) {
+                first_stale = survivors;
+            }
+            if (current->index < blockchain->verified_upto) {
+                verified++;
+            }
+            current->index = survivors;
+            blockchain->company_codes[survivors] = current->company;
+            blockchain->location_codes[survivors] = current->location;
+            blockchain->blocks[survivors++] = current;
         }
-        previous = current;
-        current = current->next;
+        current = next;
+    }
+
+    blockchain->next_index = survivors;
+    blockchain->tombstones = 0;
+    blockchain->verified_upto = verified;
+    blockchain->dirty_from = -1;
+    if (first_stale >= 0 && first_stale < survivors) {
+        mark_dirty(blockchain, first_stale);
+    }
+    rehash_pending(blockchain);
+    defer_keyword_index(blockchain); // Positions changed
+    if (blockchain->file != NULL) {
+        chain_file_rewrite(blockchain->file, blockchain);
+    }
+    return dropped;
+}
+
+// Function to delete a job
+// Deletion leaves a tombstone; once they make up a quarter of the chain they
+// are compacted away in one batch.
+int delete_job(Blockchain* blockchain, const char* job_id) {
+    Block* block = find_job(blockchain, job_id);
+    if (block == NULL) {
+        return 0; // Job not found
+    }
+    tombstone_block(blockchain, block);
+    if (blockchain->tombstones >= COMPACT_MIN_TOMBSTONES && blockchain->tombstones * 4 >= blockchain->next_index) {
+        compact_blockchain(blockchain);
     }
-    return 0; // Job not found
+    return 1; // Deletion successful
 }
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "job_dictionary.h"
+
+#define DICTIONARY_MIN_CAPACITY 64
+
+// Hash a string (FNV-1a)
+static size_t hash_string(const char* string) {
+    size_t h = 2166136261u;
+    while (*string) {
+        h ^= (unsigned char)*string++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// The entry for a code: segment k starts at code 64 * (2^k - 1)
+static char** dictionary_entry(const StringDictionary* dictionary, uint32_t code) {
+    uint32_t block = code / DICTIONARY_MIN_CAPACITY + 1;
+    int segment = 31 - __builtin_clz(block);
+    return &dictionary->segments[segment][code - DICTIONARY_MIN_CAPACITY * ((1u << segment) - 1)];
+}
+
+// Find the slot holding string, or the empty slot where it would go
+static size_t dictionary_probe(const StringDictionary* dictionary, const char* string) {
+    size_t mask = dictionary->slot_capacity - 1;
+    size_t slot = hash_string(string) & mask;
+    while (dictionary->slots[slot] != 0 && strcmp(*dictionary_entry(dictionary, dictionary->slots[slot] - 1), string) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Grow the slot table and re-insert every code
+static void dictionary_grow(StringDictionary* dictionary) {
+    size_t capacity = dictionary->slot_capacity ? dictionary->slot_capacity * 2 : DICTIONARY_MIN_CAPACITY;
+    free(dictionary->slots);
+    dictionary->slots = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    if (!dictionary->slots) {
+        fprintf(stderr, "Error: Memory allocation failed for string dictionary.\n");
+        exit(1);
+    }
+    dictionary->slot_capacity = capacity;
+    for (uint32_t code = 0; code < dictionary->count; code++) {
+        dictionary->slots[dictionary_probe(dictionary, *dictionary_entry(dictionary, code))] = code + 1;
+    }
+}
+
+// Function to initialize an empty dictionary
+void dictionary_init(StringDictionary* dictionary) {
+    for (int segment = 0; segment < DICTIONARY_SEGMENTS; segment++) {
+        dictionary->segments[segment] = NULL;
+    }
+    dictionary->count = 0;
+    dictionary->slots = NULL;
+    dictionary->slot_capacity = 0;
+}
+
+// Function to release every string in the dictionary
+void dictionary_free(StringDictionary* dictionary) {
+    for (uint32_t code = 0; code < dictionary->count; code++) {
+        free(*dictionary_entry(dictionary, code));
+    }
+    for (int segment = 0; segment < DICTIONARY_SEGMENTS; segment++) {
+        free(dictionary->segments[segment]);
+    }
+    free(dictionary->slots);
+    dictionary_init(dictionary);
+}
+
+// Function to get the code for a string, adding it if it is new
+uint32_t dictionary_intern(StringDictionary* dictionary, const char* string) {
+    if ((dictionary->count + 1) * 2 > dictionary->slot_capacity) {
+        dictionary_grow(dictionary);
+    }
+    size_t slot = dictionary_probe(dictionary, string);
+    if (dictionary->slots[slot] != 0) {
+        return dictionary->slots[slot] - 1;
+    }
+
+    uint32_t code = dictionary->count;
+    if (code == DICTIONARY_NO_CODE) {
+        fprintf(stderr, "Error: String dictionary is full.\n");
+        exit(1);
+    }
+    int segment = 31 - __builtin_clz(code / DICTIONARY_MIN_CAPACITY + 1);
+    if (dictionary->segments[segment] == NULL) {
+        dictionary->segments[segment] = (char**)malloc(((size_t)DICTIONARY_MIN_CAPACITY << segment) * sizeof(char*));
+        if (!dictionary->segments[segment]) {
+            fprintf(stderr, "Error: Memory allocation failed for string dictionary.\n");
+            exit(1);
+        }
+    }
+    char* copy = strdup(string);
+    if (!copy) {
+        fprintf(stderr, "Error: Memory allocation failed for interned string.\n");
+        exit(1);
+    }
+    *dictionary_entry(dictionary, code) = copy;
+    dictionary->slots[slot] = code + 1;
+    __atomic_store_n(&dictionary->count, code + 1, __ATOMIC_RELEASE); // The string is complete before its code is
+    return code;
+}
+
+// Function to get the code for a string without adding it (DICTIONARY_NO_CODE if absent)
+uint32_t dictionary_find(const StringDictionary* dictionary, const char* string) {
+    if (dictionary->slot_capacity == 0) {
+        return DICTIONARY_NO_CODE;
+    }
+    uint32_t entry = dictionary->slots[dictionary_probe(dictionary, string)];
+    return entry != 0 ? entry - 1 : DICTIONARY_NO_CODE;
+}
+
+// Function to get the string for a code
+// Safe to call from any thread for a code it was handed, while another thread interns.
+const char* dictionary_string(const StringDictionary* dictionary, uint32_t code) {
+    return code < __atomic_load_n(&dictionary->count, __ATOMIC_ACQUIRE) ? *dictionary_entry(dictionary, code) : "";
+}
@@ -0,0 +1,28 @@
+#ifndef JOB_DICTIONARY_H
+#define JOB_DICTIONARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DICTIONARY_NO_CODE UINT32_MAX // Never assigned to a string
+
+#define DICTIONARY_SEGMENTS 27        // Segment k holds 64 << k codes, enough for every uint32_t code
+
+// Interned strings: each distinct value is stored once and named by a small code
+// Strings live in segments that are never reallocated, so a code handed to
+// another thread stays readable while more strings are interned.
+typedef struct {
+    char** segments[DICTIONARY_SEGMENTS]; // Code -> string, split into doubling segments
+    uint32_t count;                 // Codes assigned so far (codes are 0..count-1)
+    uint32_t* slots;                // Open-addressing table of code + 1 (0 = empty)
+    size_t slot_capacity;           // Number of slots (power of two)
+} StringDictionary;
+
+// Function prototypes
+void dictionary_init(StringDictionary* dictionary);
+void dictionary_free(StringDictionary* dictionary);
+uint32_t dictionary_intern(StringDictionary* dictionary, const char* string);
+uint32_t dictionary_find(const StringDictionary* dictionary, const char* string);
+const char* dictionary_string(const StringDictionary* dictionary, uint32_t code);
+
+#endif
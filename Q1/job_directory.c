@@ -1,7 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
 #include "block.h"
+#include "chain_file.h"
+#include "job_import.h"
+#include "job_render.h"
+#include "job_server.h"
 
 // Function to display the menu and get user input
 void print_menu() {
@@ -13,30 +18,240 @@ void print_menu() {
     printf("5. Delete Job\n");
     printf("6. Verify Integrity\n");
     printf("7. Exit\n");
+    printf("8. Show Metrics\n");
     printf("Enter your choice: ");
 }
 
-// Function to get job details from the user
-void get_job_details(Job *job) {
-    printf("Enter Job ID (e.g., J0001): ");
-    scanf(" %5s", job->id); // Read job ID
-    printf("Enter Job Title: ");
-    scanf(" %[^\n]%*c", job->title); // Reads input with spaces
-    printf("Enter Company: ");
-    scanf(" %[^\n]%*c", job->company);
-    printf("Enter Location: ");
-    scanf(" %[^\n]%*c", job->location);
-    printf("Enter Job Description: ");
-    scanf(" %[^\n]%*c", job->description);
+// Function to print command-line usage
+static void print_usage(const char* program) {
+    printf("Usage: %s [--file <chain file>] [--import <csv|jsonl file>] [--compact] [--verify] [--threads <n>]\n", program);
+    printf("       %*s [--prove <job id>] [--verify-range <begin>:<end>]\n", (int)strlen(program), "");
+    printf("       %*s [--list | --search <query>] [--company <name>] [--location <name>]\n", (int)strlen(program), "");
+    printf("       %*s [--format text|jsonl] [--offset <n>] [--limit <n>] [--serve <socket path>]\n", (int)strlen(program), "");
+    printf("       %*s [--metrics text|json]\n", (int)strlen(program), "");
+    printf("  --file <path>     Load the chain from path and append every change to it\n");
+    printf("  --import <path>   Append every job in a CSV or JSONL file, report the rate and exit\n");
+    printf("  --compact         Drop deleted jobs from the chain (and rewrite the chain file), then exit\n");
+    printf("  --verify          Re-hash every block, report the result and exit\n");
+    printf("  --threads <n>     Worker threads for --verify and reader threads for --serve (default: one per CPU)\n");
+    printf("  --prove <id>      Print the Merkle root and an inclusion proof for a job, check it and exit\n");
+    printf("  --verify-range <begin>:<end>  Check blocks begin..end-1 against the Merkle root and exit\n");
+    printf("  --list            Print every job listing and exit\n");
+    printf("  --search <query>  Print the jobs matching every word of query and exit\n");
+    printf("  --company <name>  Only list or search jobs at this company (exact match)\n");
+    printf("  --location <name> Only list or search jobs in this location (exact match)\n");
+    printf("  --format <fmt>    Output format for --list and --search: text (default) or jsonl\n");
+    printf("  --offset <n>      Skip the first n jobs of the output\n");
+    printf("  --limit <n>       Print at most n jobs\n");
+    printf("  --serve <path>    Answer SEARCH, GET, LIST, COUNT and ADD commands on a Unix socket until interrupted\n");
+    printf("  --metrics <fmt>   Print operation latencies to stderr on exit and on SIGUSR1: text (default) or json\n");
+    printf("                    (recorded only when built with -DENABLE_METRICS)\n");
 }
 
-int main() {
-    Block* blockchain = NULL;
-    Block* last_block = NULL;
+// Function to serve queries on a Unix socket until SIGINT or SIGTERM
+static int run_server(Blockchain* blockchain, const char* socket_path, int threads, FILE* out) {
+    QueryServer server;
+    sigset_t signals;
+    int signal_number;
+
+    // Block the signals in every thread so sigwait below receives them
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    if (server_start(&server, blockchain, socket_path, threads) != 0) {
+        return 0;
+    }
+    fprintf(out, "Serving %d job listings on '%s' with %d reader threads (Ctrl-C to stop).\n", blockchain->count,
+            socket_path, server.reader_count);
+    fflush(out);
+    sigwait(&signals, &signal_number);
+    server_stop(&server);
+    fprintf(out, "Answered %ld commands and appended %ld jobs.\n", atomic_load(&server.queries),
+            atomic_load(&server.appended));
+    return 1;
+}
+
+// Function to run a full parallel verification and report it
+static int run_full_verification(Blockchain* blockchain, int threads, FILE* out) {
+    VerifyResult result;
+    verify_chain(blockchain, VERIFY_FULL, threads, &result);
+    if (result.intact) {
+        fprintf(out, "Blockchain integrity verified. No tampering detected.\n");
+    } else {
+        fprintf(out, "Blockchain integrity compromised at block %d!\n", result.first_invalid);
+    }
+    fprintf(out, "Re-hashed %d blocks in %.3f s (%.0f blocks/sec).\n", result.rehashed, result.seconds,
+            result.seconds > 0 ? result.rehashed / result.seconds : 0.0);
+    return result.intact;
+}
+
+// Function to print a job's Merkle inclusion proof and check it
+static int run_proof(Blockchain* blockchain, const char* job_id, FILE* out) {
+    MerkleProof proof;
+    unsigned char root[MERKLE_HASH_LENGTH];
+    char hex[HASH_LENGTH];
+    if (!prove_job(blockchain, job_id, &proof, root)) {
+        fprintf(out, "Job with ID %s not found.\n", job_id);
+        return 0;
+    }
+    hash_to_hex(root, hex);
+    fprintf(out, "Merkle root: %s\n", hex);
+    fprintf(out, "Job %s is leaf %zu of %zu:\n", job_id, proof.index, proof.tree_size);
+    for (int i = 0; i < proof.length; i++) {
+        hash_to_hex(proof.path[i], hex);
+        fprintf(out, "  %s\n", hex);
+    }
+    int valid = merkle_verify_proof(find_job(blockchain, job_id)->hash, &proof, root);
+    fprintf(out, valid ? "Proof verified.\n" : "Proof does not match the root!\n");
+    return valid;
+}
+
+// Function to check a range of blocks against the Merkle root and report it
+static int run_range_verification(Blockchain* blockchain, const char* range, FILE* out) {
+    int begin, end;
+    if (sscanf(range, "%d:%d", &begin, &end) != 2) {
+        fprintf(out, "Invalid range '%s' (expected <begin>:<end>).\n", range);
+        return 0;
+    }
+    int intact = verify_block_range(blockchain, begin, end, NULL);
+    if (intact < 0) {
+        fprintf(out, "Range %d:%d is empty or outside the chain (%d blocks).\n", begin, end, blockchain->next_index);
+    } else if (intact) {
+        fprintf(out, "Blocks %d to %d verified against the Merkle root.\n", begin, end - 1);
+    } else {
+        fprintf(out, "Blocks %d to %d do not match the Merkle root!\n", begin, end - 1);
+    }
+    return intact > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Blockchain blockchain;
+    ChainFile chain_file;
+    const char* chain_path = NULL;
+    const char* import_path = NULL;
+    const char* search_query = NULL;
+    const char* company = NULL;
+    const char* location = NULL;
+    const char* prove_id = NULL;
+    const char* verify_range = NULL;
+    const char* serve_path = NULL;
+    RenderFormat format = RENDER_TEXT;
+    MetricsFormat metrics_format = METRICS_TEXT;
+    int metrics_on_exit = 0;
+    int verify_only = 0;
+    int compact_only = 0;
+    int list_only = 0;
+    int threads = 0;
+    int offset = 0;
+    int limit = 0;
     int choice;
     Job job;
     int integrity_verified;
 
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            chain_path = argv[++i];
+        } else if (strcmp(argv[i], "--import") == 0 && i + 1 < argc) {
+            import_path = argv[++i];
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            compact_only = 1;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify_only = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--prove") == 0 && i + 1 < argc) {
+            prove_id = argv[++i];
+        } else if (strcmp(argv[i], "--verify-range") == 0 && i + 1 < argc) {
+            verify_range = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_path = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list_only = 1;
+        } else if (strcmp(argv[i], "--search") == 0 && i + 1 < argc) {
+            search_query = argv[++i];
+        } else if (strcmp(argv[i], "--company") == 0 && i + 1 < argc) {
+            company = argv[++i];
+        } else if (strcmp(argv[i], "--location") == 0 && i + 1 < argc) {
+            location = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "text") == 0 || strcmp(argv[i + 1], "jsonl") == 0)) {
+            format = strcmp(argv[++i], "jsonl") == 0 ? RENDER_JSONL : RENDER_TEXT;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "text") == 0 || strcmp(argv[i + 1], "json") == 0)) {
+            metrics_format = strcmp(argv[++i], "json") == 0 ? METRICS_JSON : METRICS_TEXT;
+            metrics_on_exit = 1;
+        } else if (strcmp(argv[i], "--offset") == 0 && i + 1 < argc) {
+            offset = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Keep stdout clean for listings that other tools will read
+    int exporting = list_only || search_query != NULL;
+    FILE* info = exporting ? stderr : stdout;
+
+    // Before any worker thread starts, so they all leave SIGUSR1 to the dumper
+    metrics_dump_on_signal(SIGUSR1, stderr, metrics_format, chain_metric_names, CHAIN_METRIC_COUNT);
+
+    initialize_blockchain(&blockchain);
+    if (chain_path != NULL) {
+        if (chain_file_open(&chain_file, chain_path, &blockchain) != 0) {
+            return 1;
+        }
+        fprintf(info, "Loaded %d job listings from '%s'.\n", blockchain.count, chain_path);
+    }
+    if (import_path != NULL || compact_only || verify_only || prove_id != NULL || verify_range != NULL || exporting ||
+        serve_path != NULL) {
+        int status = 0;
+        if (import_path != NULL) {
+            ImportStats stats;
+            status = import_jobs(&blockchain, import_path, IMPORT_AUTO, &stats) == 0 ? 0 : 1;
+            if (status == 0) {
+                fprintf(info, "Imported %d jobs in %.3f s (%.0f jobs/sec), skipped %d lines.\n", stats.imported,
+                        stats.seconds, stats.seconds > 0 ? stats.imported / stats.seconds : 0.0, stats.skipped);
+            }
+        }
+        if (status == 0 && compact_only) {
+            fprintf(info, "Compacted the chain: dropped %d deleted jobs.\n", compact_blockchain(&blockchain));
+        }
+        if (status == 0 && verify_only) {
+            status = run_full_verification(&blockchain, threads, info) ? 0 : 2;
+        }
+        if (status == 0 && verify_range != NULL) {
+            status = run_range_verification(&blockchain, verify_range, info) ? 0 : 2;
+        }
+        if (status == 0 && prove_id != NULL) {
+            status = run_proof(&blockchain, prove_id, info) ? 0 : 2;
+        }
+        if (status == 0 && list_only && company == NULL && location == NULL) {
+            render_jobs(&blockchain, NULL, stdout, format, offset, limit);
+        } else if (status == 0 && exporting) {
+            PostingList results = {NULL, 0, 0};
+            filter_jobs(&blockchain, search_query, QUERY_ALL, company, location, &results);
+            render_jobs(&blockchain, &results, stdout, format, offset, limit);
+            posting_list_free(&results);
+        }
+        if (status == 0 && serve_path != NULL) {
+            status = run_server(&blockchain, serve_path, threads, info) ? 0 : 1;
+        }
+        if (metrics_on_exit) {
+            metrics_dump(stderr, metrics_format, chain_metric_names, CHAIN_METRIC_COUNT);
+        }
+        if (chain_path != NULL && chain_file_recover(&chain_file, &blockchain) != 0 && status == 0) {
+            status = 1; // Changes since a failed write are lost
+        }
+        free_blockchain(&blockchain);
+        if (chain_path != NULL) {
+            chain_file_close(&chain_file);
+        }
+        release_block_storage();
+        return status;
+    }
     printf("Welcome to the Blockchain Job Directory Application!\n");
 
     do {
@@ -49,22 +264,15 @@ int main() {
                 // Add job listing
                 get_job_details(&job);
 
-                // Create and add a new block
-                if (blockchain == NULL) {
-                    last_block = create_block(job, "0");
-                    blockchain = last_block;
-                } else {
-                    Block* new_block = create_block(job, last_block->hash);
-                    add_block(&blockchain, new_block);
-                    last_block = new_block; // Update the last block reference
-                }
+                // Create a new block linked to the current tail and append it
+                add_block(&blockchain, create_block(job, blockchain.tail ? blockchain.tail->hash : NULL));
                 printf("Job listing added successfully!\n");
                 break;
 
             case 2:
                 // List all jobs
                 printf("Listing all job listings:\n");
-                list_jobs(blockchain);
+                list_jobs(&blockchain);
                 break;
 
             case 3:
@@ -72,14 +280,14 @@ int main() {
                 printf("Enter keyword to search for jobs: ");
                 scanf(" %[^\n]%*c", job.title);
                 printf("Searching for jobs with keyword '%s':\n", job.title);
-                search_job(blockchain, job.title);
+                search_job(&blockchain, job.title);
                 break;
 
             case 4:
                 // Modify a job
                 printf("Enter Job ID to modify: ");
                 scanf(" %5s", job.id);
-                if (modify_job(blockchain, job.id)) {
+                if (modify_job(&blockchain, job.id)) {
                     printf("Job modified successfully!\n");
                 } else {
                     printf("Job not found.\n");
@@ -99,7 +307,7 @@ int main() {
 
             case 6:
                 // Verify blockchain integrity
-                integrity_verified = verify_integrity(blockchain);
+                integrity_verified = verify_integrity(&blockchain);
                 if (integrity_verified) {
                     printf("Blockchain integrity verified. No tampering detected.\n");
                 } else {
@@ -112,11 +320,28 @@ int main() {
                 printf("Exiting the program. Goodbye!\n");
                 break;
 
+            case 8:
+                // Show operation counts and latencies
+                metrics_dump(stdout, METRICS_TEXT, chain_metric_names, CHAIN_METRIC_COUNT);
+                break;
+
             default:
                 printf("Invalid choice. Please enter a valid option.\n");
         }
 
     } while (choice != 7);
 
-    return 0;
+    if (metrics_on_exit) {
+        metrics_dump(stderr, metrics_format, chain_metric_names, CHAIN_METRIC_COUNT);
+    }
+    int status = 0;
+    if (chain_path != NULL && chain_file_recover(&chain_file, &blockchain) != 0) {
+        status = 1; // Changes since a failed write are lost
+    }
+    free_blockchain(&blockchain);
+    if (chain_path != NULL) {
+        chain_file_close(&chain_file);
+    }
+    release_block_storage();
+    return status;
 }
@@ -0,0 +1,439 @@
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <openssl/sha.h>
+#include "job_import.h"
+
+// A batch of jobs moving through the parse -> hash -> link pipeline
+typedef struct {
+    int count;                      // Jobs in this batch
+    int last;                       // Set on the final (possibly empty) batch
+    Job jobs[IMPORT_BATCH_JOBS];    // Parsed jobs
+    SHA256_CTX contexts[IMPORT_BATCH_JOBS]; // Hashes with the job text absorbed
+} ImportBatch;
+
+// Bounded blocking queue of batches between two stages
+typedef struct {
+    ImportBatch* items[IMPORT_BATCHES];
+    int head;                       // Next batch to pop
+    int count;                      // Batches queued
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} BatchQueue;
+
+// State shared by the pipeline stages
+typedef struct {
+    FILE* input;
+    ImportFormat format;
+    BatchQueue free_batches;        // Empty batches for the parser
+    BatchQueue parsed;              // Parser -> hasher
+    BatchQueue hashed;              // Hasher -> linker
+    int skipped;                    // Lines the parser rejected
+    char* line;                     // Parser's line buffer (getline)
+    size_t line_capacity;
+    long line_number;
+    int first_line;                 // No non-blank line read yet
+} ImportPipeline;
+
+static void queue_init(BatchQueue* queue) {
+    queue->head = 0;
+    queue->count = 0;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+}
+
+static void queue_destroy(BatchQueue* queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+}
+
+static void queue_push(BatchQueue* queue, ImportBatch* batch) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == IMPORT_BATCHES) {
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+    }
+    queue->items[(queue->head + queue->count) % IMPORT_BATCHES] = batch;
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static ImportBatch* queue_pop(BatchQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+    }
+    ImportBatch* batch = queue->items[queue->head];
+    queue->head = (queue->head + 1) % IMPORT_BATCHES;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return batch;
+}
+
+// Append one character to a bounded field, silently truncating
+static void put_char(char* out, size_t size, size_t* length, char c) {
+    if (*length + 1 < size) {
+        out[(*length)++] = c;
+    }
+}
+
+// Read one CSV field into out; returns the start of the next field or NULL at end of line
+static const char* read_csv_field(const char* p, char* out, size_t size) {
+    size_t length = 0;
+    if (*p == '"') {
+        p++;
+        while (*p) {
+            if (*p == '"') {
+                if (p[1] == '"') { // Escaped quote
+                    put_char(out, size, &length, '"');
+                    p += 2;
+                    continue;
+                }
+                p++;
+                break;
+            }
+            put_char(out, size, &length, *p++);
+        }
+        while (*p && *p != ',') {
+            p++; // Ignore anything between the closing quote and the delimiter
+        }
+    } else {
+        while (*p && *p != ',') {
+            put_char(out, size, &length, *p++);
+        }
+    }
+    out[length] = '\0';
+    return *p == ',' ? p + 1 : NULL;
+}
+
+// Function to parse "id,title,company,location,description" (RFC 4180 quoting, single line)
+// Returns 1 on success, 0 if the line is not a job.
+int parse_csv_job(const char* line, Job* job) {
+    char* fields[] = {job->id, job->title, job->company, job->location, job->description};
+    size_t sizes[] = {JOB_ID_LENGTH, TITLE_LENGTH, COMPANY_LENGTH, LOCATION_LENGTH, DESCRIPTION_LENGTH};
+    const char* p = line;
+
+    for (int f = 0; f < 5; f++) {
+        if (p == NULL) {
+            return 0; // Too few fields
+        }
+        p = read_csv_field(p, fields[f], sizes[f]);
+    }
+    return job->id[0] != '\0';
+}
+
+static const char* skip_spaces(const char* p) {
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    return p;
+}
+
+// Read a JSON string starting at its opening quote into out (NULL to discard)
+// Returns a pointer past the closing quote, or NULL if the string is malformed.
+static const char* read_json_string(const char* p, char* out, size_t size) {
+    size_t length = 0;
+    if (*p++ != '"') {
+        return NULL;
+    }
+    while (*p && *p != '"') {
+        char c = *p++;
+        if (c == '\\') {
+            c = *p++;
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u': {
+                    unsigned int code = 0;
+                    for (int i = 0; i < 4; i++, p++) {
+                        if (!isxdigit((unsigned char)*p)) {
+                            return NULL;
+                        }
+                        code = code * 16 + (isdigit((unsigned char)*p) ? *p - '0' : (tolower((unsigned char)*p) - 'a' + 10));
+                    }
+                    if (out != NULL && code >= 0x80) { // Encode as UTF-8 (surrogates become '?')
+                        if (code >= 0xD800 && code <= 0xDFFF) {
+                            put_char(out, size, &length, '?');
+                        } else if (code < 0x800) {
+                            put_char(out, size, &length, (char)(0xC0 | (code >> 6)));
+                            put_char(out, size, &length, (char)(0x80 | (code & 0x3F)));
+                        } else {
+                            put_char(out, size, &length, (char)(0xE0 | (code >> 12)));
+                            put_char(out, size, &length, (char)(0x80 | ((code >> 6) & 0x3F)));
+                            put_char(out, size, &length, (char)(0x80 | (code & 0x3F)));
+                        }
+                        continue;
+                    }
+                    c = (char)code;
+                    break;
+                }
+                case '\0':
+                    return NULL;
+                default:
+                    break; // \" \\ \/ map to themselves
+            }
+        }
+        if (out != NULL) {
+            put_char(out, size, &length, c);
+        }
+    }
+    if (*p != '"') {
+        return NULL;
+    }
+    if (out != NULL) {
+        out[length] = '\0';
+    }
+    return p + 1;
+}
+
+// Function to parse one JSON object with string fields id, title, company,
+// location and description (unknown keys and scalar values are ignored)
+// Returns 1 on success, 0 if the line is not a job.
+int parse_jsonl_job(const char* line, Job* job) {
+    static const char* keys[] = {"id", "title", "company", "location", "description"};
+    char* fields[] = {job->id, job->title, job->company, job->location, job->description};
+    size_t sizes[] = {JOB_ID_LENGTH, TITLE_LENGTH, COMPANY_LENGTH, LOCATION_LENGTH, DESCRIPTION_LENGTH};
+    const char* p = skip_spaces(line);
+
+    memset(job, 0, sizeof(*job));
+    if (*p++ != '{') {
+        return 0;
+    }
+    p = skip_spaces(p);
+    while (*p != '}') {
+        char key[32];
+        p = read_json_string(p, key, sizeof(key));
+        if (p == NULL) {
+            return 0;
+        }
+        p = skip_spaces(p);
+        if (*p++ != ':') {
+            return 0;
+        }
+        p = skip_spaces(p);
+
+        int field = -1;
+        for (int f = 0; f < 5; f++) {
+            if (strcmp(key, keys[f]) == 0) {
+                field = f;
+            }
+        }
+        if (*p == '"') {
+            p = read_json_string(p, field >= 0 ? fields[field] : NULL, field >= 0 ? sizes[field] : 0);
+            if (p == NULL) {
+                return 0;
+            }
+        } else if (isalnum((unsigned char)*p) || *p == '-') {
+            // Numbers, true/false/null: copy the raw token (e.g. a numeric id)
+            size_t length = 0;
+            while (isalnum((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.') {
+                if (field >= 0) {
+                    put_char(fields[field], sizes[field], &length, *p);
+                }
+                p++;
+            }
+            if (field >= 0) {
+                fields[field][length] = '\0';
+            }
+        } else {
+            return 0; // Nested objects and arrays are not supported
+        }
+
+        p = skip_spaces(p);
+        if (*p == ',') {
+            p = skip_spaces(p + 1);
+        } else if (*p != '}') {
+            return 0;
+        }
+    }
+    return job->id[0] != '\0';
+}
+
+// Strip a trailing newline (and carriage return) in place
+static void chomp(char* line) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+        line[--length] = '\0';
+    }
+}
+
+// Read lines into an empty batch until it is full or the input ends (then batch->last is set)
+static void parse_batch(ImportPipeline* pipeline, ImportBatch* batch) {
+    while (getline(&pipeline->line, &pipeline->line_capacity, pipeline->input) >= 0) {
+        char* line = pipeline->line;
+        pipeline->line_number++;
+        chomp(line);
+        const char* start = skip_spaces(line);
+        if (*start == '\0') {
+            continue;
+        }
+        if (pipeline->first_line && pipeline->format == IMPORT_AUTO) {
+            pipeline->format = *start == '{' ? IMPORT_JSONL : IMPORT_CSV;
+        }
+
+        Job* job = &batch->jobs[batch->count];
+        int parsed = pipeline->format == IMPORT_JSONL ? parse_jsonl_job(line, job) : parse_csv_job(line, job);
+        if (pipeline->first_line && pipeline->format == IMPORT_CSV && parsed && strcasecmp(job->id, "id") == 0) {
+            parsed = -1; // Header row
+        }
+        pipeline->first_line = 0;
+        if (parsed == 0) {
+            if (pipeline->skipped++ < 10) {
+                fprintf(stderr, "Warning: Skipping malformed line %ld.\n", pipeline->line_number);
+            }
+            continue;
+        }
+        if (parsed < 0) {
+            continue;
+        }
+
+        if (++batch->count == IMPORT_BATCH_JOBS) {
+            return;
+        }
+    }
+    batch->last = 1;
+}
+
+// Parse stage: read lines into batches
+static void* parse_stage(void* arg) {
+    ImportPipeline* pipeline = (ImportPipeline*)arg;
+    int last;
+    do {
+        ImportBatch* batch = queue_pop(&pipeline->free_batches);
+        parse_batch(pipeline, batch);
+        last = batch->last;
+        queue_push(&pipeline->parsed, batch);
+    } while (!last);
+    return NULL;
+}
+
+// Absorb each job's text so only the previous hash is left to add
+static void hash_batch(ImportBatch* batch) {
+    for (int i = 0; i < batch->count; i++) {
+        const Job* job = &batch->jobs[i];
+        begin_block_hash(&batch->contexts[i], job->title, job->company, job->location, job->description);
+    }
+}
+
+// Hash stage: hash parsed batches
+static void* hash_stage(void* arg) {
+    ImportPipeline* pipeline = (ImportPipeline*)arg;
+    int last;
+    do {
+        ImportBatch* batch = queue_pop(&pipeline->parsed);
+        hash_batch(batch);
+        last = batch->last;
+        queue_push(&pipeline->hashed, batch);
+    } while (!last);
+    return NULL;
+}
+
+// Function to append every job in a CSV or JSONL file to the chain
+// Parsing and hashing of the job text run on their own threads, ahead of the
+// calling thread, which finishes each hash with the previous block's hash and
+// links the block. A stage whose thread cannot be created runs on the calling
+// thread instead. The resulting chain is the same as adding each job with
+// create_block/add_block. Returns 0 on success, -1 if the file cannot be read.
+int import_jobs(Blockchain* blockchain, const char* path, ImportFormat format, ImportStats* stats) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    ImportPipeline pipeline;
+    pipeline.input = fopen(path, "r");
+    if (pipeline.input == NULL) {
+        fprintf(stderr, "Error: Unable to open import file '%s'.\n", path);
+        return -1;
+    }
+    pipeline.format = format;
+    pipeline.skipped = 0;
+    pipeline.line = NULL;
+    pipeline.line_capacity = 0;
+    pipeline.line_number = 0;
+    pipeline.first_line = 1;
+    queue_init(&pipeline.free_batches);
+    queue_init(&pipeline.parsed);
+    queue_init(&pipeline.hashed);
+
+    ImportBatch* batches = (ImportBatch*)malloc(IMPORT_BATCHES * sizeof(ImportBatch));
+    if (!batches) {
+        fprintf(stderr, "Error: Memory allocation failed for import batches.\n");
+        exit(1);
+    }
+    for (int i = 0; i < IMPORT_BATCHES; i++) {
+        batches[i].count = 0;
+        batches[i].last = 0;
+        queue_push(&pipeline.free_batches, &batches[i]);
+    }
+
+    // The keyword index is rebuilt on the next search rather than per job
+    defer_keyword_index(blockchain);
+    rehash_pending(blockchain);
+
+    // Without a parser thread the whole pipeline runs here, one batch at a time;
+    // without a hasher thread this thread hashes what the parser hands it
+    pthread_t parser, hasher;
+    int parsing = pthread_create(&parser, NULL, parse_stage, &pipeline) == 0;
+    int hashing = parsing && pthread_create(&hasher, NULL, hash_stage, &pipeline) == 0;
+
+    // Link stage
+    int imported = 0;
+    int last;
+    do {
+        ImportBatch* batch;
+        if (hashing) {
+            batch = queue_pop(&pipeline.hashed);
+        } else {
+            if (parsing) {
+                batch = queue_pop(&pipeline.parsed);
+            } else {
+                batch = queue_pop(&pipeline.free_batches);
+                parse_batch(&pipeline, batch);
+            }
+            hash_batch(batch);
+        }
+        for (int i = 0; i < batch->count; i++) {
+            const unsigned char* prev_hash = blockchain->tail ? blockchain->tail->hash : NULL;
+            unsigned char zeros[DIGEST_LENGTH] = {0};
+            unsigned char hash[DIGEST_LENGTH];
+            finish_block_hash(&batch->contexts[i], prev_hash ? prev_hash : zeros, hash);
+            add_block(blockchain, create_hashed_block(&batch->jobs[i], prev_hash, hash));
+        }
+        imported += batch->count;
+        last = batch->last;
+        batch->count = 0;
+        queue_push(&pipeline.free_batches, batch);
+    } while (!last);
+
+    if (parsing) {
+        pthread_join(parser, NULL);
+    }
+    if (hashing) {
+        pthread_join(hasher, NULL);
+    }
+    free(pipeline.line);
+    fclose(pipeline.input);
+    queue_destroy(&pipeline.free_batches);
+    queue_destroy(&pipeline.parsed);
+    queue_destroy(&pipeline.hashed);
+    free(batches);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (stats != NULL) {
+        stats->imported = imported;
+        stats->skipped = pipeline.skipped;
+        stats->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef JOB_IMPORT_H
+#define JOB_IMPORT_H
+
+#include "block.h"
+
+#define IMPORT_BATCH_JOBS 256       // Jobs handed between pipeline stages at a time
+#define IMPORT_BATCHES 16           // Batches in flight; bounds the pipeline's memory
+
+// Input formats understood by import_jobs
+typedef enum {
+    IMPORT_AUTO,                    // JSONL if the first non-blank character is '{', CSV otherwise
+    IMPORT_CSV,                     // id,title,company,location,description (optional header row)
+    IMPORT_JSONL                    // One {"id": ..., "title": ..., ...} object per line
+} ImportFormat;
+
+// Outcome of import_jobs
+typedef struct {
+    int imported;                   // Jobs appended to the chain
+    int skipped;                    // Lines that could not be parsed
+    double seconds;                 // Wall-clock time for the whole import
+} ImportStats;
+
+// Function prototypes
+int import_jobs(Blockchain* blockchain, const char* path, ImportFormat format, ImportStats* stats);
+int parse_csv_job(const char* line, Job* job);
+int parse_jsonl_job(const char* line, Job* job);
+
+#endif
@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "job_index.h"
+
+#define KEYWORD_INDEX_MIN_CAPACITY 256
+
+// Hash a term (FNV-1a)
+static size_t hash_term(const char* term) {
+    size_t h = 2166136261u;
+    while (*term) {
+        h ^= (unsigned char)*term++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Find the slot holding term, or the empty slot where it would go
+static size_t keyword_index_probe(const KeywordIndex* index, const char* term) {
+    size_t mask = index->capacity - 1;
+    size_t slot = hash_term(term) & mask;
+    while (index->entries[slot].term != NULL && strcmp(index->entries[slot].term, term) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Grow the term table and re-insert every term
+static void keyword_index_grow(KeywordIndex* index) {
+    KeywordEntry* old_entries = index->entries;
+    size_t old_capacity = index->capacity;
+    size_t new_capacity = old_capacity ? old_capacity * 2 : KEYWORD_INDEX_MIN_CAPACITY;
+
+    index->entries = (KeywordEntry*)calloc(new_capacity, sizeof(KeywordEntry));
+    if (!index->entries) {
+        fprintf(stderr, "Error: Memory allocation failed for keyword index.\n");
+        exit(1);
+    }
+    index->capacity = new_capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].term != NULL) {
+            index->entries[keyword_index_probe(index, old_entries[i].term)] = old_entries[i];
+        }
+    }
+    free(old_entries);
+}
+
+// Get the posting list for a term, creating an empty one if needed
+static PostingList* keyword_index_get(KeywordIndex* index, const char* term) {
+    if ((index->used + 1) * 2 > index->capacity) {
+        keyword_index_grow(index);
+    }
+    KeywordEntry* entry = &index->entries[keyword_index_probe(index, term)];
+    if (entry->term == NULL) {
+        entry->term = strdup(term);
+        if (!entry->term) {
+            fprintf(stderr, "Error: Memory allocation failed for keyword.\n");
+            exit(1);
+        }
+        index->used++;
+    }
+    return &entry->postings;
+}
+
+// Find the first position in a posting list that is >= position
+static int posting_list_lower_bound(const PostingList* list, int position) {
+    int low = 0, high = list->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (list->positions[mid] < position) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Make room for at least one more position
+static void posting_list_reserve(PostingList* list, int needed) {
+    if (needed <= list->capacity) {
+        return;
+    }
+    int capacity = list->capacity ? list->capacity : 4;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    int* positions = (int*)realloc(list->positions, capacity * sizeof(int));
+    if (!positions) {
+        fprintf(stderr, "Error: Memory allocation failed for posting list.\n");
+        exit(1);
+    }
+    list->positions = positions;
+    list->capacity = capacity;
+}
+
+// Insert a position keeping the list sorted and free of duplicates
+static void posting_list_insert(PostingList* list, int position) {
+    // Appends are the common case: blocks are indexed in chain order
+    if (list->count == 0 || list->positions[list->count - 1] < position) {
+        posting_list_append(list, position);
+        return;
+    }
+    int at = posting_list_lower_bound(list, position);
+    if (list->positions[at] == position) {
+        return;
+    }
+    posting_list_reserve(list, list->count + 1);
+    memmove(&list->positions[at + 1], &list->positions[at], (list->count - at) * sizeof(int));
+    list->positions[at] = position;
+    list->count++;
+}
+
+// Remove a position from a sorted list if present
+static void posting_list_erase(PostingList* list, int position) {
+    int at = posting_list_lower_bound(list, position);
+    if (at == list->count || list->positions[at] != position) {
+        return;
+    }
+    memmove(&list->positions[at], &list->positions[at + 1], (list->count - at - 1) * sizeof(int));
+    list->count--;
+}
+
+// Function to extract the next lower-cased keyword from text
+// Returns a pointer just past the keyword, or NULL when no keyword remains.
+// length receives the full keyword length; only the first KEYWORD_MAX_LENGTH
+// characters are written to term.
+const char* next_keyword(const char* text, char* term, size_t* length) {
+    while (*text && !isalnum((unsigned char)*text)) {
+        text++;
+    }
+    if (*text == '\0') {
+        return NULL;
+    }
+    size_t n = 0;
+    while (isalnum((unsigned char)*text)) {
+        if (n < KEYWORD_MAX_LENGTH) {
+            term[n] = (char)tolower((unsigned char)*text);
+        }
+        n++;
+        text++;
+    }
+    term[n < KEYWORD_MAX_LENGTH ? n : KEYWORD_MAX_LENGTH] = '\0';
+    *length = n;
+    return text;
+}
+
+// Remove the term in slot, shifting later terms of its probe run back into the gap
+static void keyword_index_erase(KeywordIndex* index, size_t slot) {
+    size_t mask = index->capacity - 1;
+    free(index->entries[slot].term);
+    posting_list_free(&index->entries[slot].postings);
+    index->used--;
+    for (size_t next = (slot + 1) & mask; index->entries[next].term != NULL; next = (next + 1) & mask) {
+        size_t home = hash_term(index->entries[next].term) & mask;
+        // Move the entry unless its home lies cyclically in (slot, next]
+        if ((next > slot && (home <= slot || home > next)) || (next < slot && home <= slot && home > next)) {
+            index->entries[slot] = index->entries[next];
+            slot = next;
+        }
+    }
+    index->entries[slot].term = NULL;
+    index->entries[slot].postings = (PostingList){NULL, 0, 0};
+}
+
+// Function to initialize an empty keyword index
+void keyword_index_init(KeywordIndex* index) {
+    index->entries = NULL;
+    index->capacity = 0;
+    index->used = 0;
+}
+
+// Function to release every term and posting list
+void keyword_index_free(KeywordIndex* index) {
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->entries[i].term != NULL) {
+            free(index->entries[i].term);
+            posting_list_free(&index->entries[i].postings);
+        }
+    }
+    free(index->entries);
+    keyword_index_init(index);
+}
+
+// Function to index every keyword of text under a block position
+// A word too long to index puts the position under KEYWORD_LONG_TERM instead.
+void keyword_index_add(KeywordIndex* index, int position, const char* text) {
+    char term[KEYWORD_MAX_LENGTH + 1];
+    size_t length;
+    while ((text = next_keyword(text, term, &length)) != NULL) {
+        posting_list_insert(keyword_index_get(index, length <= KEYWORD_MAX_LENGTH ? term : KEYWORD_LONG_TERM), position);
+    }
+}
+
+// Function to drop a block position from the postings of every keyword in text
+// Terms left without postings are removed from the table.
+void keyword_index_remove(KeywordIndex* index, int position, const char* text) {
+    char term[KEYWORD_MAX_LENGTH + 1];
+    size_t length;
+    while ((text = next_keyword(text, term, &length)) != NULL) {
+        if (index->capacity == 0) {
+            return;
+        }
+        size_t slot = keyword_index_probe(index, length <= KEYWORD_MAX_LENGTH ? term : KEYWORD_LONG_TERM);
+        if (index->entries[slot].term != NULL) {
+            posting_list_erase(&index->entries[slot].postings, position);
+            if (index->entries[slot].postings.count == 0) {
+                keyword_index_erase(index, slot);
+            }
+        }
+    }
+}
+
+// Function to look up the posting list of a lower-cased term (NULL if no job has it)
+const PostingList* keyword_index_lookup(const KeywordIndex* index, const char* term) {
+    if (index->capacity == 0) {
+        return NULL;
+    }
+    const KeywordEntry* entry = &index->entries[keyword_index_probe(index, term)];
+    return entry->term != NULL ? &entry->postings : NULL;
+}
+
+// Function to merge the postings of every indexed keyword that contains part
+// part is a lower-cased keyword; reserved terms are skipped. This scans the
+// term table, which is far smaller than the chain.
+void keyword_index_containing(const KeywordIndex* index, const char* part, PostingList* out) {
+    out->count = 0;
+    for (size_t i = 0; i < index->capacity; i++) {
+        const KeywordEntry* entry = &index->entries[i];
+        if (entry->term != NULL && isalnum((unsigned char)entry->term[0]) && strstr(entry->term, part) != NULL) {
+            posting_list_union(out, &entry->postings);
+        }
+    }
+}
+
+// Function to release a posting list
+void posting_list_free(PostingList* list) {
+    free(list->positions);
+    list->positions = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+// Function to append a position larger than every position already in the list
+void posting_list_append(PostingList* list, int position) {
+    posting_list_reserve(list, list->count + 1);
+    list->positions[list->count++] = position;
+}
+
+// Function to copy a posting list into an empty one
+void posting_list_copy(PostingList* out, const PostingList* list) {
+    posting_list_reserve(out, list->count);
+    if (list->count > 0) {
+        memcpy(out->positions, list->positions, list->count * sizeof(int));
+    }
+    out->count = list->count;
+}
+
+// Function to keep only the positions of acc that are also in other (AND)
+void posting_list_intersect(PostingList* acc, const PostingList* other) {
+    int i = 0, j = 0, kept = 0;
+    while (i < acc->count && j < other->count) {
+        if (acc->positions[i] < other->positions[j]) {
+            i++;
+        } else if (acc->positions[i] > other->positions[j]) {
+            j++;
+        } else {
+            acc->positions[kept++] = acc->positions[i];
+            i++;
+            j++;
+        }
+    }
+    acc->count = kept;
+}
+
+// Function to merge the positions of other into acc (OR)
+void posting_list_union(PostingList* acc, const PostingList* other) {
+    PostingList merged = {NULL, 0, 0};
+    posting_list_reserve(&merged, acc->count + other->count);
+    int i = 0, j = 0;
+    while (i < acc->count || j < other->count) {
+        int next;
+        if (j == other->count || (i < acc->count && acc->positions[i] < other->positions[j])) {
+            next = acc->positions[i++];
+        } else if (i == acc->count || other->positions[j] < acc->positions[i]) {
+            next = other->positions[j++];
+        } else {
+            next = acc->positions[i++];
+            j++;
+        }
+        merged.positions[merged.count++] = next;
+    }
+    posting_list_free(acc);
+    *acc = merged;
+}
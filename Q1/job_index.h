@@ -0,0 +1,49 @@
+#ifndef JOB_INDEX_H
+#define JOB_INDEX_H
+
+#include <stddef.h>
+
+#define KEYWORD_MAX_LENGTH 32 // Longer words are not indexed and are matched by scanning
+#define KEYWORD_LONG_TERM "*"  // Reserved term: blocks with a word longer than KEYWORD_MAX_LENGTH
+
+// Sorted list of block positions (block indexes) containing a term
+typedef struct {
+    int* positions;                 // Ascending block indexes
+    int count;                      // Number of positions in use
+    int capacity;                   // Allocated positions
+} PostingList;
+
+// One term of the inverted index
+typedef struct {
+    char* term;                     // Lower-cased keyword, NULL for an empty slot
+    PostingList postings;           // Blocks whose title or description contain the term
+} KeywordEntry;
+
+// Inverted index from lower-cased keywords to posting lists
+typedef struct {
+    KeywordEntry* entries;          // Open-addressing table of terms
+    size_t capacity;                // Number of slots (power of two)
+    size_t used;                    // Number of distinct terms
+} KeywordIndex;
+
+// How multi-term queries combine their terms
+typedef enum {
+    QUERY_ALL,                      // Every term must match (AND)
+    QUERY_ANY                       // At least one term must match (OR)
+} QueryMode;
+
+// Function prototypes
+void keyword_index_init(KeywordIndex* index);
+void keyword_index_free(KeywordIndex* index);
+void keyword_index_add(KeywordIndex* index, int position, const char* text);
+void keyword_index_remove(KeywordIndex* index, int position, const char* text);
+const PostingList* keyword_index_lookup(const KeywordIndex* index, const char* term);
+void keyword_index_containing(const KeywordIndex* index, const char* part, PostingList* out);
+const char* next_keyword(const char* text, char* term, size_t* length);
+void posting_list_free(PostingList* list);
+void posting_list_append(PostingList* list, int position);
+void posting_list_copy(PostingList* out, const PostingList* list);
+void posting_list_intersect(PostingList* acc, const PostingList* other);
+void posting_list_union(PostingList* acc, const PostingList* other);
+
+#endif
@@ -0,0 +1,258 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "job_render.h"
+
+static pthread_key_t buffer_key;
+static pthread_once_t buffer_key_once = PTHREAD_ONCE_INIT;
+static __thread char* idle_buffer = NULL;   // This thread's buffer while no renderer holds it
+
+// Free a thread's buffer when it exits
+static void release_buffer(void* buffer) {
+    free(buffer);
+}
+
+static void create_buffer_key(void) {
+    pthread_key_create(&buffer_key, release_buffer);
+}
+
+// Take this thread's buffer, allocating it on first use; a nested renderer gets its own
+static char* take_buffer(void) {
+    char* buffer = idle_buffer;
+    idle_buffer = NULL;
+    if (!buffer) {
+        buffer = (char*)malloc(RENDER_BUFFER_SIZE);
+        if (!buffer) {
+            fprintf(stderr, "Error: Memory allocation failed for output buffer.\n");
+            exit(1);
+        }
+    }
+    return buffer;
+}
+
+// Keep a buffer for the thread's next renderer, or free it if the thread already has one
+static void return_buffer(char* buffer) {
+    if (idle_buffer) {
+        free(buffer);
+        return;
+    }
+    pthread_once(&buffer_key_once, create_buffer_key);
+    pthread_setspecific(buffer_key, buffer);
+    idle_buffer = buffer;
+}
+
+// Function to start rendering a page of jobs to out
+// Jobs passed to render_block before offset are counted but not written; once
+// limit jobs have been written (limit > 0) render_block returns 0.
+void renderer_init(Renderer* renderer, FILE* out, RenderFormat format, int offset, int limit) {
+    renderer->out = out;
+    renderer->format = format;
+    renderer->offset = offset > 0 ? offset : 0;
+    renderer->limit = limit > 0 ? limit : 0;
+    renderer->seen = 0;
+    renderer->rendered = 0;
+    renderer->used = 0;
+    renderer->cached_minute = -1;
+    renderer->cached_time[0] = '\0';
+    renderer->buffer = take_buffer();
+}
+
+// Write out everything buffered so far
+static void renderer_flush(Renderer* renderer) {
+    if (renderer->used > 0) {
+        fwrite(renderer->buffer, 1, renderer->used, renderer->out);
+        renderer->used = 0;
+    }
+}
+
+// Function to write out any buffered jobs and hand the buffer back to the thread
+void renderer_finish(Renderer* renderer) {
+    renderer_flush(renderer);
+    fflush(renderer->out);
+    return_buffer(renderer->buffer);
+    renderer->buffer = NULL;
+}
+
+static void append_bytes(Renderer* renderer, const char* text, size_t length) {
+    memcpy(renderer->buffer + renderer->used, text, length);
+    renderer->used += length;
+}
+
+static void append_string(Renderer* renderer, const char* text) {
+    append_bytes(renderer, text, strlen(text));
+}
+
+static void append_long(Renderer* renderer, long long value) {
+    char digits[24];
+    int length = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[sizeof(digits) - 1 - length++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[sizeof(digits) - 1 - length++] = '-';
+    }
+    append_bytes(renderer, digits + sizeof(digits) - length, (size_t)length);
+}
+
+static void append_hex(Renderer* renderer, const unsigned char digest[DIGEST_LENGTH]) {
+    hash_to_hex(digest, renderer->buffer + renderer->used);
+    renderer->used += DIGEST_LENGTH * 2;
+}
+
+// Append a JSON string literal, escaping quotes, backslashes and control characters
+static void append_json_string(Renderer* renderer, const char* text) {
+    static const char hex[] = "0123456789abcdef";
+    char* out = renderer->buffer + renderer->used;
+    *out++ = '"';
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            *out++ = '\\';
+            *out++ = (char)*p;
+        } else if (*p == '\n') {
+            *out++ = '\\';
+            *out++ = 'n';
+        } else if (*p == '\t') {
+            *out++ = '\\';
+            *out++ = 't';
+        } else if (*p < 0x20) {
+            memcpy(out, "\\u00", 4);
+            out[4] = hex[*p >> 4];
+            out[5] = hex[*p & 0x0f];
+            out += 6;
+        } else {
+            *out++ = (char)*p;
+        }
+    }
+    *out++ = '"';
+    renderer->used = (size_t)(out - renderer->buffer);
+}
+
+// Append a timestamp in ctime format ("Www Mmm dd hh:mm:ss yyyy")
+// localtime_r runs once per distinct minute; time zones are offset from UTC by
+// whole minutes, so the seconds field can be patched in directly.
+static void append_ctime(Renderer* renderer, time_t timestamp) {
+    time_t second = ((timestamp % 60) + 60) % 60;
+    time_t minute = timestamp - second;
+    if (minute != renderer->cached_minute) {
+        struct tm local;
+        if (localtime_r(&minute, &local) == NULL ||
+            strftime(renderer->cached_time, sizeof(renderer->cached_time), "%a %b %e %H:%M:%S %Y", &local) != 24) {
+            renderer->cached_time[0] = '\0';
+        }
+        renderer->cached_minute = minute;
+    }
+    if (renderer->cached_time[0] == '\0') {
+        append_long(renderer, (long long)timestamp); // Outside the range ctime can format
+        return;
+    }
+    char* out = renderer->buffer + renderer->used;
+    memcpy(out, renderer->cached_time, 24);
+    out[17] = (char)('0' + second / 10);
+    out[18] = (char)('0' + second % 10);
+    renderer->used += 24;
+}
+
+static void render_text(Renderer* renderer, const Block* block) {
+    append_string(renderer, "Job ID: ");
+    append_string(renderer, block->id);
+    append_string(renderer, "\nTitle: ");
+    append_string(renderer, block->text->title);
+    append_string(renderer, "\nCompany: ");
+    append_string(renderer, job_string(block->company));
+    append_string(renderer, "\nLocation: ");
+    append_string(renderer, job_string(block->location));
+    append_string(renderer, "\nDescription: ");
+    append_string(renderer, block->text->description);
+    append_string(renderer, "\nTimestamp: ");
+    append_ctime(renderer, block->timestamp);
+    append_string(renderer, "\nHash: ");
+    append_hex(renderer, block->hash);
+    append_string(renderer, "\nPrevious Hash: ");
+    append_hex(renderer, block->previous_hash);
+    append_string(renderer, "\n--------------------\n");
+}
+
+static void render_json(Renderer* renderer, const Block* block) {
+    append_string(renderer, "{\"index\":");
+    append_long(renderer, block->index);
+    append_string(renderer, ",\"id\":");
+    append_json_string(renderer, block->id);
+    append_string(renderer, ",\"title\":");
+    append_json_string(renderer, block->text->title);
+    append_string(renderer, ",\"company\":");
+    append_json_string(renderer, job_string(block->company));
+    append_string(renderer, ",\"location\":");
+    append_json_string(renderer, job_string(block->location));
+    append_string(renderer, ",\"description\":");
+    append_json_string(renderer, block->text->description);
+    append_string(renderer, ",\"timestamp\":");
+    append_long(renderer, (long long)block->timestamp);
+    append_string(renderer, ",\"hash\":\"");
+    append_hex(renderer, block->hash);
+    append_string(renderer, "\",\"previous_hash\":\"");
+    append_hex(renderer, block->previous_hash);
+    append_string(renderer, "\"}\n");
+}
+
+// Function to render one matching job if it falls inside the page
+// Deleted jobs are skipped without counting toward the offset. Returns 0 once
+// the page is full, 1 while more jobs are wanted.
+int render_block(Renderer* renderer, const Block* block) {
+    if (renderer->limit > 0 && renderer->rendered >= renderer->limit) {
+        return 0;
+    }
+    if (block->flags & BLOCK_DELETED) {
+        return 1;
+    }
+    if (renderer->seen++ < renderer->offset) {
+        return 1;
+    }
+    if (renderer->used + RENDER_MAX_RECORD > RENDER_BUFFER_SIZE) {
+        renderer_flush(renderer);
+    }
+    if (renderer->format == RENDER_JSONL) {
+        render_json(renderer, block);
+    } else {
+        render_text(renderer, block);
+    }
+    renderer->rendered++;
+    return renderer->limit == 0 || renderer->rendered < renderer->limit;
+}
+
+// Function to render a page of jobs: the blocks at positions, or the whole chain if positions is NULL
+// Returns the number of jobs written.
+int render_jobs(Blockchain* blockchain, const PostingList* positions, FILE* out, RenderFormat format,
+                int offset, int limit) {
+    Renderer renderer;
+    rehash_pending(blockchain); // Printed hashes must be current
+    renderer_init(&renderer, out, format, offset, limit);
+
+    if (positions != NULL) {
+        int i = renderer.offset < positions->count ? renderer.offset : positions->count;
+        renderer.seen = i; // Results are an array, so skipped pages cost nothing
+        for (; i < positions->count; i++) {
+            if (!render_block(&renderer, blockchain->blocks[positions->positions[i]])) {
+                break;
+            }
+        }
+    } else {
+        const Block* current = blockchain->head;
+        if (blockchain->count == blockchain->next_index && renderer.offset > 0) {
+            // No tombstones: position n holds the n-th job, so jump straight to the page
+            current = renderer.offset < blockchain->count ? blockchain->blocks[renderer.offset] : NULL;
+            renderer.seen = renderer.offset;
+        }
+        for (; current != NULL; current = current->next) {
+            if (!render_block(&renderer, current)) {
+                break;
+            }
+        }
+    }
+
+    renderer_finish(&renderer);
+    return renderer.rendered;
+}
@@ -0,0 +1,38 @@
+#ifndef JOB_RENDER_H
+#define JOB_RENDER_H
+
+#include <stdio.h>
+#include <time.h>
+#include "block.h"
+
+#define RENDER_BUFFER_SIZE (256 * 1024) // Output is written in chunks of about this size
+#define RENDER_MAX_RECORD 8192          // Upper bound on one rendered job (JSON escaping included)
+
+// Output formats for job listings
+typedef enum {
+    RENDER_TEXT,                    // The interactive "Job ID: ..." layout
+    RENDER_JSONL                    // One JSON object per job
+} RenderFormat;
+
+// Buffered writer for a page of job listings
+typedef struct {
+    FILE* out;                      // Destination stream
+    RenderFormat format;
+    int offset;                     // Matching jobs to skip before the first one rendered
+    int limit;                      // Jobs to render at most (0 = no limit)
+    int seen;                       // Matching jobs passed to render_block so far
+    int rendered;                   // Jobs written to the buffer so far
+    char* buffer;                   // The calling thread's reusable buffer, held until renderer_finish
+    size_t used;                    // Bytes in buffer not yet written
+    time_t cached_minute;           // Start of the minute cached_time describes
+    char cached_time[32];           // ctime-style "Www Mmm dd hh:mm:00 yyyy" for cached_minute
+} Renderer;
+
+// Function prototypes
+void renderer_init(Renderer* renderer, FILE* out, RenderFormat format, int offset, int limit);
+int render_block(Renderer* renderer, const Block* block);
+void renderer_finish(Renderer* renderer);
+int render_jobs(Blockchain* blockchain, const PostingList* positions, FILE* out, RenderFormat format,
+                int offset, int limit);
+
+#endif
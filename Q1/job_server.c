@@ -0,0 +1,739 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "job_server.h"
+#include "job_import.h"
+#include "job_render.h"
+
+#define SHARED_MIN_CAPACITY 64
+#define SHARED_MIN_POSTINGS 4
+#define ID_TERM_PREFIX '#'          // Job ID terms; keywords are alphanumeric, so they never collide
+
+// Published blocks: entries below count are complete and never change
+typedef struct SharedTable {
+    int capacity;
+    _Atomic int count;
+    Block* blocks[];
+} SharedTable;
+
+// Postings of one term; positions only ever grow at the end
+typedef struct {
+    char* term;
+    _Atomic(int*) positions;
+    _Atomic int count;
+    int capacity;                   // Writer only
+} SharedPostings;
+
+// Open-addressing table of terms; a slot is written once, from NULL
+typedef struct SharedTerms {
+    size_t capacity;                // Power of two
+    size_t used;                    // Writer only
+    _Atomic(SharedPostings*) slots[];
+} SharedTerms;
+
+// Memory replaced by the writer, freed once no reader can still see it
+typedef struct RetiredMemory {
+    void* pointer;
+    uint64_t epoch;                 // Value of the server epoch when it was retired
+    struct RetiredMemory* next;
+} RetiredMemory;
+
+// A job queued for the writer by a reader thread
+typedef struct PendingJob {
+    Job job;
+    int index;                      // Block index assigned by the writer
+    int done;                       // Set once the job is published
+    struct PendingJob* next;
+} PendingJob;
+
+// A client connection, parked in the server's epoll set between commands
+typedef struct ServerConnection {
+    int fd;
+    FILE* out;                      // Buffered replies, written through a dup of fd
+    char* line;                     // Bytes received but not yet answered
+    atomic_size_t used;             // Released on parking, acquired by the reader that takes it next
+    struct ServerConnection* previous; // Every open connection, so stopping can close them
+    struct ServerConnection* next;
+} ServerConnection;
+
+// A consistent view of the chain for one query
+typedef struct {
+    SharedTable* table;
+    int count;                      // Blocks visible in this snapshot
+} Snapshot;
+
+static void* checked_malloc(size_t size) {
+    void* memory = malloc(size);
+    if (!memory) {
+        fprintf(stderr, "Error: Memory allocation failed for query server.\n");
+        exit(1);
+    }
+    return memory;
+}
+
+// Hash a term (FNV-1a, as the keyword index does)
+static size_t hash_term(const char* term) {
+    size_t h = 2166136261u;
+    while (*term) {
+        h ^= (unsigned char)*term++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Hand memory that readers may still be using to the reclaimer
+static void retire(QueryServer* server, void* pointer) {
+    RetiredMemory* retired = (RetiredMemory*)checked_malloc(sizeof(RetiredMemory));
+    retired->pointer = pointer;
+    retired->epoch = atomic_fetch_add(&server->epoch, 1);
+    retired->next = server->retired;
+    server->retired = retired;
+}
+
+// Free retired memory that every active reader entered after
+// A reader announces the epoch before loading any shared pointer, so one that
+// announced a later epoch than the retirement can only see the replacement.
+static void reclaim(QueryServer* server, int force) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < server->reader_count && !force; i++) {
+        uint64_t epoch = atomic_load(&server->slots[i].epoch);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    RetiredMemory** link = &server->retired;
+    while (*link != NULL) {
+        RetiredMemory* retired = *link;
+        if (force || retired->epoch < oldest) {
+            *link = retired->next;
+            free(retired->pointer);
+            free(retired);
+        } else {
+            link = &retired->next;
+        }
+    }
+}
+
+// Announce the reader's epoch, then take the published table and block count
+static void snapshot_begin(ServerReader* reader, Snapshot* snapshot) {
+    QueryServer* server = reader->server;
+    atomic_store(&server->slots[reader->slot].epoch, atomic_load(&server->epoch));
+    snapshot->table = atomic_load(&server->table);
+    snapshot->count = atomic_load(&snapshot->table->count);
+}
+
+// Let the writer reclaim anything this snapshot could see
+static void snapshot_end(ServerReader* reader) {
+    atomic_store(&reader->server->slots[reader->slot].epoch, 0);
+}
+
+// Allocate an empty term table
+static SharedTerms* terms_create(size_t capacity) {
+    SharedTerms* terms = (SharedTerms*)checked_malloc(sizeof(SharedTerms) + capacity * sizeof(SharedPostings*));
+    terms->capacity = capacity;
+    terms->used = 0;
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&terms->slots[i], NULL);
+    }
+    return terms;
+}
+
+// Find the postings of term, or the empty slot where they would go
+static size_t terms_probe(const SharedTerms* terms, const char* term) {
+    size_t mask = terms->capacity - 1;
+    size_t slot = hash_term(term) & mask;
+    SharedPostings* postings;
+    while ((postings = atomic_load(&terms->slots[slot])) != NULL && strcmp(postings->term, term) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Get the postings of a term, adding it if it is new (writer only)
+static SharedPostings* terms_get(QueryServer* server, const char* term) {
+    SharedTerms* terms = atomic_load(&server->terms);
+    if ((terms->used + 1) * 2 > terms->capacity) {
+        // Readers keep probing the old table until the new one is published
+        SharedTerms* grown = terms_create(terms->capacity * 2);
+        for (size_t i = 0; i < terms->capacity; i++) {
+            SharedPostings* postings = atomic_load(&terms->slots[i]);
+            if (postings != NULL) {
+                atomic_store(&grown->slots[terms_probe(grown, postings->term)], postings);
+            }
+        }
+        grown->used = terms->used;
+        atomic_store(&server->terms, grown);
+        retire(server, terms);
+        terms = grown;
+    }
+    size_t slot = terms_probe(terms, term);
+    SharedPostings* postings = atomic_load(&terms->slots[slot]);
+    if (postings == NULL) {
+        postings = (SharedPostings*)checked_malloc(sizeof(SharedPostings));
+        postings->term = strdup(term);
+        if (!postings->term) {
+            fprintf(stderr, "Error: Memory allocation failed for query server.\n");
+            exit(1);
+        }
+        atomic_init(&postings->positions, (int*)checked_malloc(SHARED_MIN_POSTINGS * sizeof(int)));
+        atomic_init(&postings->count, 0);
+        postings->capacity = SHARED_MIN_POSTINGS;
+        atomic_store(&terms->slots[slot], postings);
+        terms->used++;
+    }
+    return postings;
+}
+
+// Append a block position to the postings of term (writer only)
+static void postings_add(QueryServer* server, const char* term, int position) {
+    SharedPostings* postings = terms_get(server, term);
+    int count = atomic_load_explicit(&postings->count, memory_order_relaxed);
+    int* positions = atomic_load_explicit(&postings->positions, memory_order_relaxed);
+    if (count > 0 && positions[count - 1] == position) {
+        return; // Term repeated within the same job
+    }
+    if (count == postings->capacity) {
+        int* grown = (int*)checked_malloc((size_t)count * 2 * sizeof(int));
+        memcpy(grown, positions, (size_t)count * sizeof(int));
+        atomic_store(&postings->positions, grown);
+        retire(server, positions);
+        postings->capacity = count * 2;
+        positions = grown;
+    }
+    positions[count] = position;
+    atomic_store(&postings->count, count + 1);
+}
+
+// Index a block's keywords and job ID (writer only)
+static void index_block(QueryServer* server, const Block* block) {
+    const char* fields[] = {block->text->title, block->text->description};
+    char term[KEYWORD_MAX_LENGTH + 2];
+    size_t length;
+    for (int f = 0; f < 2; f++) {
+        const char* text = fields[f];
+        while ((text = next_keyword(text, term, &length)) != NULL) {
+            postings_add(server, length <= KEYWORD_MAX_LENGTH ? term : KEYWORD_LONG_TERM, block->index);
+        }
+    }
+    term[0] = ID_TERM_PREFIX;
+    memcpy(term + 1, block->id, JOB_ID_LENGTH);
+    term[JOB_ID_LENGTH] = '\0';
+    postings_add(server, term, block->index);
+}
+
+// Write a block into the table without publishing it yet (writer only)
+static void table_add(QueryServer* server, Block* block) {
+    SharedTable* table = atomic_load(&server->table);
+    if (server->table_size == table->capacity) {
+        SharedTable* grown = (SharedTable*)checked_malloc(sizeof(SharedTable) + (size_t)table->capacity * 2 * sizeof(Block*));
+        grown->capacity = table->capacity * 2;
+        memcpy(grown->blocks, table->blocks, (size_t)server->table_size * sizeof(Block*));
+        atomic_init(&grown->count, atomic_load(&table->count));
+        atomic_store(&server->table, grown);
+        retire(server, table);
+        table = grown;
+    }
+    table->blocks[server->table_size++] = block;
+    if (!(block->flags & BLOCK_DELETED)) {
+        index_block(server, block);
+    }
+}
+
+// Make every block written to the table visible to new snapshots
+static void table_publish(QueryServer* server) {
+    atomic_store(&atomic_load(&server->table)->count, server->table_size);
+}
+
+// Append queued jobs in batches, publishing each batch with a single store
+static void* writer_main(void* arg) {
+    QueryServer* server = (QueryServer*)arg;
+    Blockchain* blockchain = server->blockchain;
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        while (server->pending == NULL && !server->closing) {
+            pthread_cond_wait(&server->work, &server->lock);
+        }
+        PendingJob* batch = server->pending;
+        server->pending = NULL;
+        server->pending_tail = NULL;
+        pthread_mutex_unlock(&server->lock);
+        if (batch == NULL) {
+            break; // Stopping with nothing left to append
+        }
+
+        long appended = 0;
+        for (PendingJob* pending = batch; pending != NULL; pending = pending->next) {
+            Block* block = create_block(pending->job, blockchain->tail ? blockchain->tail->hash : NULL);
+            add_block(blockchain, block);
+            table_add(server, block);
+            pending->index = block->index;
+            appended++;
+        }
+        table_publish(server);
+        reclaim(server, 0);
+        atomic_fetch_add(&server->appended, appended);
+
+        pthread_mutex_lock(&server->lock);
+        while (batch != NULL) {
+            PendingJob* next = batch->next; // batch lives on a waiting reader's stack
+            batch->done = 1;
+            batch = next;
+        }
+        pthread_cond_broadcast(&server->committed);
+        pthread_mutex_unlock(&server->lock);
+    }
+    return NULL;
+}
+
+// Queue a job for the writer and wait until it is published; returns its block index
+static int submit_job(QueryServer* server, const Job* job) {
+    PendingJob pending;
+    pending.job = *job;
+    pending.index = -1;
+    pending.done = 0;
+    pending.next = NULL;
+
+    pthread_mutex_lock(&server->lock);
+    if (server->pending_tail != NULL) {
+        server->pending_tail->next = &pending;
+    } else {
+        server->pending = &pending;
+    }
+    server->pending_tail = &pending;
+    pthread_cond_signal(&server->work);
+    while (!pending.done) {
+        pthread_cond_wait(&server->committed, &server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return pending.index;
+}
+
+// Positions of a term's postings visible in the snapshot, as a read-only view
+static void postings_view(const SharedPostings* postings, const Snapshot* snapshot, PostingList* view) {
+    // The count is loaded first: every array published since holds at least that many
+    int count = atomic_load(&postings->count);
+    int* positions = atomic_load(&postings->positions);
+    while (count > 0 && positions[count - 1] >= snapshot->count) {
+        count--; // Written by the writer but not yet part of this snapshot
+    }
+    view->positions = positions;
+    view->count = count;
+    view->capacity = 0;
+}
+
+// Positions of term visible in the snapshot, as a read-only view (count 0 if absent)
+static int snapshot_postings(QueryServer* server, const Snapshot* snapshot, const char* term, PostingList* view) {
+    SharedTerms* terms = atomic_load(&server->terms);
+    SharedPostings* postings = atomic_load(&terms->slots[terms_probe(terms, term)]);
+    view->positions = NULL;
+    view->count = 0;
+    view->capacity = 0;
+    if (postings == NULL) {
+        return 0;
+    }
+    postings_view(postings, snapshot, view);
+    return 1;
+}
+
+// Scan the snapshot for jobs containing needle
+static void snapshot_scan(const Snapshot* snapshot, const char* needle, size_t length, PostingList* out) {
+    for (int i = 0; i < snapshot->count; i++) {
+        const Block* block = snapshot->table->blocks[i];
+        if (!(block->flags & BLOCK_DELETED) && block_contains(block, needle, length)) {
+            posting_list_append(out, i);
+        }
+    }
+}
+
+// Collect the jobs in the snapshot containing a query word, whole or as part of a longer word
+// Same rules as search_jobs: the postings of every term containing it, and
+// jobs under KEYWORD_LONG_TERM checked directly.
+static void snapshot_match_word(QueryServer* server, const Snapshot* snapshot, const char* word, size_t length,
+                                const char* term, PostingList* out) {
+    PostingList view;
+    if (length <= KEYWORD_MAX_LENGTH) {
+        SharedTerms* terms = atomic_load(&server->terms);
+        for (size_t i = 0; i < terms->capacity; i++) {
+            SharedPostings* postings = atomic_load(&terms->slots[i]);
+            if (postings != NULL && isalnum((unsigned char)postings->term[0]) && strstr(postings->term, term) != NULL) {
+                postings_view(postings, snapshot, &view);
+                posting_list_union(out, &view);
+            }
+        }
+    }
+    if (snapshot_postings(server, snapshot, KEYWORD_LONG_TERM, &view)) {
+        PostingList scanned = {NULL, 0, 0};
+        for (int i = 0; i < view.count; i++) {
+            if (block_contains(snapshot->table->blocks[view.positions[i]], word, length)) {
+                posting_list_append(&scanned, view.positions[i]);
+            }
+        }
+        posting_list_union(out, &scanned);
+        posting_list_free(&scanned);
+    }
+}
+
+// Match a query against the snapshot with the same rules as search_jobs (every word must match)
+static void snapshot_search(QueryServer* server, const Snapshot* snapshot, const char* query, PostingList* results) {
+    char term[KEYWORD_MAX_LENGTH + 1];
+    size_t length;
+    const char* cursor = query;
+    int terms = 0;
+
+    results->count = 0;
+    while ((cursor = next_keyword(cursor, term, &length)) != NULL) {
+        PostingList matched = {NULL, 0, 0};
+        snapshot_match_word(server, snapshot, cursor - length, length, term, &matched);
+        if (terms++ == 0) {
+            posting_list_free(results); // The first word's matches become the results
+            *results = matched;
+        } else {
+            posting_list_intersect(results, &matched);
+            posting_list_free(&matched);
+        }
+        if (results->count == 0) {
+            break;
+        }
+    }
+    if (terms == 0) {
+        snapshot_scan(snapshot, query, strlen(query), results);
+    }
+}
+
+// Render the blocks at positions of a snapshot and end the response
+// Blocks are never freed while serving, so they stay valid after the snapshot ends.
+static void respond_blocks(FILE* out, Block** blocks, int count) {
+    Renderer renderer;
+    renderer_init(&renderer, out, RENDER_JSONL, 0, 0);
+    for (int i = 0; i < count; i++) {
+        render_block(&renderer, blocks[i]);
+    }
+    renderer_finish(&renderer);
+    fprintf(out, "OK %d\n", renderer.rendered);
+}
+
+// Collect the live blocks at positions, then leave the snapshot and render them
+static void respond_positions(ServerReader* reader, const Snapshot* snapshot, const PostingList* positions, FILE* out) {
+    Block** blocks = (Block**)checked_malloc(((size_t)positions->count + 1) * sizeof(Block*));
+    int count = 0;
+    for (int i = 0; i < positions->count; i++) {
+        Block* block = snapshot->table->blocks[positions->positions[i]];
+        if (!(block->flags & BLOCK_DELETED)) {
+            blocks[count++] = block;
+        }
+    }
+    snapshot_end(reader);
+    respond_blocks(out, blocks, count);
+    free(blocks);
+}
+
+// Answer one command line; returns 0 when the client asked to close the connection
+static int handle_command(ServerReader* reader, char* line, FILE* out) {
+    QueryServer* server = reader->server;
+    Snapshot snapshot;
+    PostingList results = {NULL, 0, 0};
+
+    atomic_fetch_add(&server->queries, 1);
+    if (strncmp(line, "SEARCH ", 7) == 0) {
+        snapshot_begin(reader, &snapshot);
+        snapshot_search(server, &snapshot, line + 7, &results);
+        respond_positions(reader, &snapshot, &results, out);
+    } else if (strncmp(line, "GET ", 4) == 0) {
+        char term[JOB_ID_LENGTH + 1] = {ID_TERM_PREFIX};
+        PostingList view;
+        strncat(term, line + 4, JOB_ID_LENGTH - 1);
+        snapshot_begin(reader, &snapshot);
+        snapshot_postings(server, &snapshot, term, &view);
+        respond_positions(reader, &snapshot, &view, out);
+    } else if (strncmp(line, "LIST", 4) == 0 && (line[4] == '\0' || line[4] == ' ')) {
+        int offset = 0, limit = 0;
+        sscanf(line + 4, "%d %d", &offset, &limit);
+        snapshot_begin(reader, &snapshot);
+        for (int i = 0; i < snapshot.count && (limit <= 0 || results.count < limit); i++) {
+            if (!(snapshot.table->blocks[i]->flags & BLOCK_DELETED) && offset-- <= 0) {
+                posting_list_append(&results, i);
+            }
+        }
+        respond_positions(reader, &snapshot, &results, out);
+    } else if (strcmp(line, "COUNT") == 0) {
+        snapshot_begin(reader, &snapshot);
+        snapshot_end(reader);
+        fprintf(out, "OK %d\n", snapshot.count);
+    } else if (strncmp(line, "ADD ", 4) == 0) {
+        Job job;
+        if (parse_jsonl_job(line + 4, &job)) {
+            fprintf(out, "OK %d\n", submit_job(server, &job));
+        } else {
+            fprintf(out, "ERR invalid job\n");
+        }
+    } else if (strcmp(line, "QUIT") == 0) {
+        return 0;
+    } else {
+        fprintf(out, "ERR unknown command\n");
+    }
+    posting_list_free(&results);
+    fflush(out);
+    return 1;
+}
+
+// Register a newly accepted connection and park it in the epoll set
+static void connection_open(QueryServer* server, int fd) {
+    struct timeval timeout = {SERVER_SEND_TIMEOUT_MS / 1000, (SERVER_SEND_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)); // A client that stops reading cannot pin a reader
+    int duplicate = dup(fd);
+    FILE* out = duplicate >= 0 ? fdopen(duplicate, "w") : NULL;
+    if (out == NULL) {
+        if (duplicate >= 0) {
+            close(duplicate);
+        }
+        close(fd);
+        return;
+    }
+    ServerConnection* connection = (ServerConnection*)checked_malloc(sizeof(ServerConnection));
+    connection->fd = fd;
+    connection->out = out;
+    connection->line = (char*)checked_malloc(SERVER_LINE_LENGTH);
+    pthread_mutex_lock(&server->lock);
+    connection->previous = NULL;
+    connection->next = server->connections;
+    if (server->connections != NULL) {
+        server->connections->previous = connection;
+    }
+    server->connections = connection;
+    pthread_mutex_unlock(&server->lock);
+    atomic_store_explicit(&connection->used, 0, memory_order_release);
+
+    struct epoll_event event = {EPOLLIN | EPOLLONESHOT, {.ptr = connection}};
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+// Unregister and close a connection (by the one thread holding it, or after the readers stopped)
+static void connection_close(QueryServer* server, ServerConnection* connection) {
+    pthread_mutex_lock(&server->lock);
+    if (connection->previous != NULL) {
+        connection->previous->next = connection->next;
+    } else {
+        server->connections = connection->next;
+    }
+    if (connection->next != NULL) {
+        connection->next->previous = connection->previous;
+    }
+    pthread_mutex_unlock(&server->lock);
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL); // out's dup would keep it registered
+    fclose(connection->out);
+    close(connection->fd);
+    free(connection->line);
+    free(connection);
+}
+
+// Receive what a ready connection has sent and answer every complete command
+// Returns 0 once the connection should be closed.
+static int serve_connection(ServerReader* reader, ServerConnection* connection) {
+    size_t used = atomic_load_explicit(&connection->used, memory_order_acquire);
+    ssize_t received = recv(connection->fd, connection->line + used, SERVER_LINE_LENGTH - used, MSG_DONTWAIT);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        return 0;
+    }
+    if (received > 0) {
+        used += (size_t)received;
+    }
+    char* line = connection->line;
+    char* newline;
+    while ((newline = memchr(line, '\n', used)) != NULL) {
+        size_t length = (size_t)(newline - line);
+        *newline = '\0';
+        if (length > 0 && line[length - 1] == '\r') {
+            line[length - 1] = '\0';
+        }
+        if (!handle_command(reader, line, connection->out)) {
+            return 0;
+        }
+        used -= length + 1;
+        memmove(line, newline + 1, used);
+    }
+    if (used == SERVER_LINE_LENGTH) {
+        fprintf(connection->out, "ERR line too long\n");
+        fflush(connection->out);
+        return 0;
+    }
+    atomic_store_explicit(&connection->used, used, memory_order_release);
+    return 1;
+}
+
+// Take ready connections from the shared epoll set, one at a time, until the server stops
+// Connections are registered one-shot, so each readiness goes to exactly one
+// reader, which answers the commands received so far and parks the connection
+// again. An idle client therefore holds no reader.
+static void* reader_main(void* arg) {
+    ServerReader* reader = (ServerReader*)arg;
+    QueryServer* server = reader->server;
+    while (!atomic_load(&server->stopping)) {
+        struct epoll_event event;
+        if (epoll_wait(server->epoll_fd, &event, 1, SERVER_POLL_MS) <= 0) {
+            continue;
+        }
+        ServerConnection* connection = (ServerConnection*)event.data.ptr;
+        if (connection == NULL) {
+            int fd = accept(server->listen_fd, NULL, NULL);
+            struct epoll_event listening = {EPOLLIN | EPOLLONESHOT, {.ptr = NULL}};
+            epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, server->listen_fd, &listening);
+            if (fd >= 0) {
+                connection_open(server, fd);
+            }
+            continue;
+        }
+        int fd = connection->fd; // Once parked, another reader may take and close it
+        if (serve_connection(reader, connection)) {
+            struct epoll_event parked = {EPOLLIN | EPOLLONESHOT, {.ptr = connection}};
+            epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, fd, &parked);
+        } else {
+            connection_close(server, connection);
+        }
+    }
+    return NULL;
+}
+
+// Create the listening socket, replacing a stale one left by an earlier run
+static int listen_on(const char* path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: Socket path '%s' is too long.\n", path);
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Error: Unable to create socket");
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 128) != 0) {
+        fprintf(stderr, "Error: Unable to listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); // Readers race to accept
+    return fd;
+}
+
+// Function to start serving queries on a Unix socket
+// Every block already in the chain is published and indexed first. From then
+// until server_stop, only the server's writer thread may touch the blockchain.
+// readers is the reader pool size (0 = one per online CPU). Returns 0 on
+// success, -1 on error.
+int server_start(QueryServer* server, Blockchain* blockchain, const char* socket_path, int readers) {
+    if (readers <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        readers = online > 0 ? (int)online : 1;
+    }
+    server->reader_count = readers < SERVER_MAX_READERS ? readers : SERVER_MAX_READERS;
+    server->listen_fd = listen_on(socket_path);
+    if (server->listen_fd < 0) {
+        return -1;
+    }
+    server->epoll_fd = epoll_create1(0);
+    struct epoll_event listening = {EPOLLIN | EPOLLONESHOT, {.ptr = NULL}}; // NULL marks the listening socket
+    if (server->epoll_fd < 0 || epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &listening) != 0) {
+        perror("Error: Unable to create the connection poll set");
+        if (server->epoll_fd >= 0) {
+            close(server->epoll_fd);
+        }
+        close(server->listen_fd);
+        unlink(socket_path);
+        return -1;
+    }
+    server->connections = NULL;
+    server->socket_path = strdup(socket_path);
+    server->blockchain = blockchain;
+    server->retired = NULL;
+    server->pending = NULL;
+    server->pending_tail = NULL;
+    atomic_init(&server->epoch, 1);
+    atomic_init(&server->stopping, 0);
+    server->closing = 0;
+    atomic_init(&server->queries, 0);
+    atomic_init(&server->appended, 0);
+    for (int i = 0; i < SERVER_MAX_READERS; i++) {
+        atomic_init(&server->slots[i].epoch, 0);
+    }
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->work, NULL);
+    pthread_cond_init(&server->committed, NULL);
+
+    // Publish the existing chain; the writer's own keyword index is not needed while serving
+    rehash_pending(blockchain);
+    defer_keyword_index(blockchain);
+    int capacity = SHARED_MIN_CAPACITY;
+    while (capacity < blockchain->next_index) {
+        capacity *= 2;
+    }
+    SharedTable* table = (SharedTable*)checked_malloc(sizeof(SharedTable) + (size_t)capacity * sizeof(Block*));
+    table->capacity = capacity;
+    atomic_init(&table->count, 0);
+    atomic_init(&server->table, table);
+    atomic_init(&server->terms, terms_create(SHARED_MIN_CAPACITY));
+    server->table_size = 0;
+    for (const Block* current = blockchain->head; current != NULL; current = current->next) {
+        table_add(server, (Block*)current);
+    }
+    table_publish(server);
+    reclaim(server, 1);
+
+    signal(SIGPIPE, SIG_IGN); // Clients that hang up mid-response must not kill the server
+    pthread_create(&server->writer, NULL, writer_main, server);
+    for (int i = 0; i < server->reader_count; i++) {
+        server->readers[i].server = server;
+        server->readers[i].slot = i;
+        pthread_create(&server->readers[i].thread, NULL, reader_main, &server->readers[i]);
+    }
+    return 0;
+}
+
+// Function to stop serving: finish open requests, join every thread and free the published state
+// The blockchain holds every job appended while serving.
+void server_stop(QueryServer* server) {
+    atomic_store(&server->stopping, 1);
+    for (int i = 0; i < server->reader_count; i++) {
+        pthread_join(server->readers[i].thread, NULL);
+    }
+    pthread_mutex_lock(&server->lock);
+    server->closing = 1;
+    pthread_cond_signal(&server->work);
+    pthread_mutex_unlock(&server->lock);
+    pthread_join(server->writer, NULL);
+
+    while (server->connections != NULL) {
+        connection_close(server, server->connections);
+    }
+    close(server->epoll_fd);
+    close(server->listen_fd);
+    unlink(server->socket_path);
+    free(server->socket_path);
+    reclaim(server, 1);
+    SharedTerms* terms = atomic_load(&server->terms);
+    for (size_t i = 0; i < terms->capacity; i++) {
+        SharedPostings* postings = atomic_load(&terms->slots[i]);
+        if (postings != NULL) {
+            free(postings->term);
+            free(atomic_load(&postings->positions));
+            free(postings);
+        }
+    }
+    free(terms);
+    free(atomic_load(&server->table));
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->work);
+    pthread_cond_destroy(&server->committed);
+}
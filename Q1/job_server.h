@@ -0,0 +1,69 @@
+#ifndef JOB_SERVER_H
+#define JOB_SERVER_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "block.h"
+
+#define SERVER_MAX_READERS 64
+#define SERVER_LINE_LENGTH 8192     // Longest command line accepted
+#define SERVER_POLL_MS 200          // How often idle threads check for shutdown
+#define SERVER_SEND_TIMEOUT_MS 5000 // Longest a reply may wait for a client that stops reading
+
+struct SharedTable;
+struct SharedTerms;
+struct RetiredMemory;
+struct PendingJob;
+struct ServerConnection;
+
+// A reader thread's announcement of the epoch it is reading in (0 = not reading)
+typedef struct {
+    _Atomic uint64_t epoch;
+    char padding[56];               // One slot per cache line
+} ReaderSlot;
+
+struct QueryServer;
+
+// One reader thread of the pool
+typedef struct {
+    struct QueryServer* server;
+    int slot;                       // Index into the server's reader slots
+    pthread_t thread;
+} ServerReader;
+
+// Query server: reader threads answer queries from published snapshots while one writer appends
+// Readers never take a lock to answer a query: the writer publishes the block table and the
+// search index with atomic pointer and count stores, and memory it replaces is
+// freed only after every reader that could still see it has finished (epochs).
+typedef struct QueryServer {
+    Blockchain* blockchain;         // Only the writer thread touches it while serving
+    int listen_fd;                  // Listening Unix socket
+    int epoll_fd;                   // Listening socket and idle connections, shared by the readers
+    struct ServerConnection* connections; // Open connections (under lock)
+    char* socket_path;              // Removed on stop
+    int reader_count;
+    ServerReader readers[SERVER_MAX_READERS];
+    ReaderSlot slots[SERVER_MAX_READERS];
+    pthread_t writer;
+    _Atomic(struct SharedTable*) table; // Published blocks, by index
+    _Atomic(struct SharedTerms*) terms; // Published keyword and job ID postings
+    _Atomic uint64_t epoch;         // Advanced each time the writer retires memory
+    struct RetiredMemory* retired;  // Replaced memory awaiting reclamation (writer only)
+    int table_size;                 // Blocks written to the table, published or not (writer only)
+    struct PendingJob* pending;     // Jobs waiting for the writer, oldest first
+    struct PendingJob* pending_tail;
+    pthread_mutex_t lock;           // Guards the pending queue and the connection list
+    pthread_cond_t work;            // Signalled when jobs are queued or the server stops
+    pthread_cond_t committed;       // Signalled when queued jobs are published
+    atomic_int stopping;            // Set to stop accepting connections and commands
+    int closing;                    // Set under lock once no reader can queue more jobs
+    atomic_long queries;            // Commands answered
+    atomic_long appended;           // Jobs appended while serving
+} QueryServer;
+
+// Function prototypes
+int server_start(QueryServer* server, Blockchain* blockchain, const char* socket_path, int readers);
+void server_stop(QueryServer* server);
+
+#endif
@@ -0,0 +1,225 @@
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/sha.h>
+#include "merkle.h"
+
+#define MERKLE_MIN_CAPACITY 64
+
+// Hash two child nodes into their parent
+static void hash_children(const unsigned char* left, const unsigned char* right, unsigned char* parent) {
+    static const unsigned char prefix = 0x01;
+    SHA256_CTX context;
+    SHA256_Init(&context);
+    SHA256_Update(&context, &prefix, 1);
+    SHA256_Update(&context, left, MERKLE_HASH_LENGTH);
+    SHA256_Update(&context, right, MERKLE_HASH_LENGTH);
+    SHA256_Final(parent, &context);
+}
+
+// The stored node of height level at position i
+static unsigned char* node_at(const MerkleTree* tree, int level, size_t i) {
+    return tree->levels[level] + i * MERKLE_HASH_LENGTH;
+}
+
+// Largest power of two strictly below size (size >= 2)
+static size_t split_point(size_t size) {
+    size_t split = 1;
+    while (split * 2 < size) {
+        split *= 2;
+    }
+    return split;
+}
+
+// Hash of the leaves in [begin, end) from the stored complete subtrees
+static void subtree_hash(const MerkleTree* tree, size_t begin, size_t end, unsigned char* out) {
+    size_t size = end - begin;
+    if (size == 0) {
+        SHA256(NULL, 0, out); // Empty tree
+        return;
+    }
+    if ((size & (size - 1)) == 0 && begin % size == 0) {
+        int level = 0;
+        while (((size_t)1 << level) < size) {
+            level++;
+        }
+        memcpy(out, node_at(tree, level, begin >> level), MERKLE_HASH_LENGTH);
+        return;
+    }
+    unsigned char left[MERKLE_HASH_LENGTH], right[MERKLE_HASH_LENGTH];
+    size_t split = split_point(size);
+    subtree_hash(tree, begin, begin + split, left);
+    subtree_hash(tree, begin + split, end, right);
+    hash_children(left, right, out);
+}
+
+// Function to initialize an empty tree
+void merkle_init(MerkleTree* tree) {
+    memset(tree, 0, sizeof(*tree));
+}
+
+// Function to release every level of the tree
+void merkle_free(MerkleTree* tree) {
+    for (int level = 0; level < MERKLE_MAX_LEVELS; level++) {
+        free(tree->levels[level]);
+    }
+    merkle_init(tree);
+}
+
+// Function to compute the leaf for a block hash: SHA-256(0x00 || block hash)
+void merkle_leaf_hash(const unsigned char block_hash[MERKLE_HASH_LENGTH], unsigned char leaf[MERKLE_HASH_LENGTH]) {
+    static const unsigned char prefix = 0x00;
+    SHA256_CTX context;
+    SHA256_Init(&context);
+    SHA256_Update(&context, &prefix, 1);
+    SHA256_Update(&context, block_hash, MERKLE_HASH_LENGTH);
+    SHA256_Final(leaf, &context);
+}
+
+// Function to grow or shrink the tree to a number of leaves
+// New leaves must be filled in with merkle_set_leaf before merkle_update.
+void merkle_resize(MerkleTree* tree, size_t leaves) {
+    for (int level = 0; level < MERKLE_MAX_LEVELS && (leaves >> level) > 0; level++) {
+        size_t needed = leaves >> level;
+        if (needed <= tree->capacity[level]) {
+            continue;
+        }
+        size_t capacity = tree->capacity[level] ? tree->capacity[level] : MERKLE_MIN_CAPACITY;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        unsigned char* nodes = (unsigned char*)realloc(tree->levels[level], capacity * MERKLE_HASH_LENGTH);
+        if (!nodes) {
+            fprintf(stderr, "Error: Memory allocation failed for Merkle tree.\n");
+            exit(1);
+        }
+        tree->levels[level] = nodes;
+        tree->capacity[level] = capacity;
+    }
+    tree->leaves = leaves;
+    if (tree->valid > leaves) {
+        tree->valid = leaves;
+    }
+}
+
+// Function to mark every leaf from index from onward as stale
+void merkle_invalidate(MerkleTree* tree, size_t from) {
+    if (from < tree->valid) {
+        tree->valid = from;
+    }
+}
+
+// Function to set the leaf for the block at index
+void merkle_set_leaf(MerkleTree* tree, size_t index, const unsigned char block_hash[MERKLE_HASH_LENGTH]) {
+    merkle_leaf_hash(block_hash, node_at(tree, 0, index));
+}
+
+// Function to recompute the interior nodes above the leaves set since the tree was last current
+// Only nodes covering a stale leaf are re-hashed, so appending k leaves costs
+// about k hashes rather than a rebuild.
+void merkle_update(MerkleTree* tree) {
+    for (int level = 1; level < MERKLE_MAX_LEVELS && (tree->leaves >> level) > 0; level++) {
+        size_t count = tree->leaves >> level;
+        for (size_t i = tree->valid >> level; i < count; i++) {
+            hash_children(node_at(tree, level - 1, 2 * i), node_at(tree, level - 1, 2 * i + 1), node_at(tree, level, i));
+        }
+    }
+    tree->valid = tree->leaves;
+}
+
+// Function to compute the root hash of a current tree
+void merkle_root(const MerkleTree* tree, unsigned char root[MERKLE_HASH_LENGTH]) {
+    subtree_hash(tree, 0, tree->leaves, root);
+}
+
+// Hash of [lo, hi) taking leaves in [begin, end) from the caller instead of the tree
+static void range_hash(const MerkleTree* tree, size_t lo, size_t hi, size_t begin, size_t end,
+                       const unsigned char (*leaves)[MERKLE_HASH_LENGTH], unsigned char* out) {
+    if (hi <= begin || lo >= end) {
+        subtree_hash(tree, lo, hi, out);
+        return;
+    }
+    if (hi - lo == 1) {
+        memcpy(out, leaves[lo - begin], MERKLE_HASH_LENGTH);
+        return;
+    }
+    unsigned char left[MERKLE_HASH_LENGTH], right[MERKLE_HASH_LENGTH];
+    size_t split = split_point(hi - lo);
+    range_hash(tree, lo, lo + split, begin, end, leaves, left);
+    range_hash(tree, lo + split, hi, begin, end, leaves, right);
+    hash_children(left, right, out);
+}
+
+// Function to compute the root the tree would have if leaves [begin, end) were replaced
+// Everything outside the range comes from stored subtrees, so this costs
+// O(end - begin + log n) hashes. Comparing the result with a trusted root
+// checks the range without touching the rest of the tree's leaves.
+void merkle_root_with_leaves(const MerkleTree* tree, size_t begin, size_t end,
+                             const unsigned char (*leaves)[MERKLE_HASH_LENGTH], unsigned char root[MERKLE_HASH_LENGTH]) {
+    if (tree->leaves == 0) {
+        subtree_hash(tree, 0, 0, root);
+        return;
+    }
+    range_hash(tree, 0, tree->leaves, begin, end, leaves, root);
+}
+
+// Collect the audit path for leaf index within [begin, end), leaf to root
+static void audit_path(const MerkleTree* tree, size_t index, size_t begin, size_t end, MerkleProof* proof) {
+    if (end - begin == 1) {
+        return;
+    }
+    size_t split = split_point(end - begin);
+    if (index < begin + split) {
+        audit_path(tree, index, begin, begin + split, proof);
+        subtree_hash(tree, begin + split, end, proof->path[proof->length++]);
+    } else {
+        audit_path(tree, index, begin + split, end, proof);
+        subtree_hash(tree, begin, begin + split, proof->path[proof->length++]);
+    }
+}
+
+// Function to build the inclusion proof for a leaf of a current tree
+// Returns 1 on success, 0 if index is out of range.
+int merkle_prove(const MerkleTree* tree, size_t index, MerkleProof* proof) {
+    if (index >= tree->leaves) {
+        return 0;
+    }
+    proof->index = index;
+    proof->tree_size = tree->leaves;
+    proof->length = 0;
+    audit_path(tree, index, 0, tree->leaves, proof);
+    return 1;
+}
+
+// Function to check that a block hash is leaf proof->index of the tree with this root
+// Follows the RFC 9162 inclusion proof verification in O(log n) hashes.
+// Returns 1 if the proof holds, 0 otherwise.
+int merkle_verify_proof(const unsigned char block_hash[MERKLE_HASH_LENGTH], const MerkleProof* proof,
+                        const unsigned char root[MERKLE_HASH_LENGTH]) {
+    if (proof->index >= proof->tree_size || proof->length < 0 || proof->length > MERKLE_MAX_LEVELS) {
+        return 0;
+    }
+    size_t fn = proof->index;
+    size_t sn = proof->tree_size - 1;
+    unsigned char hash[MERKLE_HASH_LENGTH];
+    merkle_leaf_hash(block_hash, hash);
+
+    for (int i = 0; i < proof->length; i++) {
+        if (sn == 0) {
+            return 0; // Path longer than the tree is tall
+        }
+        if ((fn & 1) || fn == sn) {
+            hash_children(proof->path[i], hash, hash);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        } else {
+            hash_children(hash, proof->path[i], hash);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && memcmp(hash, root, MERKLE_HASH_LENGTH) == 0;
+}
@@ -0,0 +1,43 @@
+#ifndef MERKLE_H
+#define MERKLE_H
+
+#include <stddef.h>
+
+#define MERKLE_HASH_LENGTH 32       // SHA-256
+#define MERKLE_MAX_LEVELS 48        // Enough for any chain that fits in memory
+
+// Merkle tree over block hashes (RFC 6962 layout: leaves are SHA-256(0x00 || block hash),
+// interior nodes SHA-256(0x01 || left || right), an unbalanced right edge is split at
+// the largest power of two). Only complete subtrees are stored; the right edge is
+// folded in when a root or proof is needed.
+typedef struct {
+    unsigned char* levels[MERKLE_MAX_LEVELS]; // levels[k] holds the leaves >> k complete nodes of height k
+    size_t capacity[MERKLE_MAX_LEVELS]; // Allocated nodes per level
+    size_t leaves;                  // Number of leaves
+    size_t valid;                   // Leaves below this index (and the nodes over them) are current
+} MerkleTree;
+
+// Inclusion proof for one leaf
+typedef struct {
+    size_t index;                   // Leaf (block) index
+    size_t tree_size;               // Number of leaves the proof is for
+    int length;                     // Hashes in path
+    unsigned char path[MERKLE_MAX_LEVELS][MERKLE_HASH_LENGTH]; // Sibling hashes, leaf to root
+} MerkleProof;
+
+// Function prototypes
+void merkle_init(MerkleTree* tree);
+void merkle_free(MerkleTree* tree);
+void merkle_leaf_hash(const unsigned char block_hash[MERKLE_HASH_LENGTH], unsigned char leaf[MERKLE_HASH_LENGTH]);
+void merkle_resize(MerkleTree* tree, size_t leaves);
+void merkle_invalidate(MerkleTree* tree, size_t from);
+void merkle_set_leaf(MerkleTree* tree, size_t index, const unsigned char block_hash[MERKLE_HASH_LENGTH]);
+void merkle_update(MerkleTree* tree);
+void merkle_root(const MerkleTree* tree, unsigned char root[MERKLE_HASH_LENGTH]);
+void merkle_root_with_leaves(const MerkleTree* tree, size_t begin, size_t end,
+                             const unsigned char (*leaves)[MERKLE_HASH_LENGTH], unsigned char root[MERKLE_HASH_LENGTH]);
+int merkle_prove(const MerkleTree* tree, size_t index, MerkleProof* proof);
+int merkle_verify_proof(const unsigned char block_hash[MERKLE_HASH_LENGTH], const MerkleProof* proof,
+                        const unsigned char root[MERKLE_HASH_LENGTH]);
+
+#endif
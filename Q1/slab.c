@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "slab.h"
+
+// Function to initialize an empty slab for objects of object_size bytes
+void slab_init(Slab* slab, size_t object_size) {
+    size_t align = sizeof(void*);
+    if (object_size < sizeof(void*)) {
+        object_size = sizeof(void*);
+    }
+    slab->object_size = (object_size + align - 1) / align * align;
+    slab->chunks = NULL;
+    slab->chunk_count = 0;
+    slab->chunk_capacity = 0;
+    slab->bump = NULL;
+    slab->bump_left = 0;
+    slab->free_list = NULL;
+    slab->live = 0;
+}
+
+// Allocate a fresh chunk and make it the bump region
+static void slab_add_chunk(Slab* slab) {
+    if (slab->chunk_count == slab->chunk_capacity) {
+        size_t capacity = slab->chunk_capacity ? slab->chunk_capacity * 2 : 16;
+        void** chunks = (void**)realloc(slab->chunks, capacity * sizeof(void*));
+        if (!chunks) {
+            fprintf(stderr, "Error: Memory allocation failed for slab chunk table.\n");
+            exit(1);
+        }
+        slab->chunks = chunks;
+        slab->chunk_capacity = capacity;
+    }
+    char* chunk = (char*)malloc(slab->object_size * SLAB_CHUNK_OBJECTS);
+    if (!chunk) {
+        fprintf(stderr, "Error: Memory allocation failed for slab chunk.\n");
+        exit(1);
+    }
+    slab->chunks[slab->chunk_count++] = chunk;
+    slab->bump = chunk;
+    slab->bump_left = SLAB_CHUNK_OBJECTS;
+}
+
+// Function to get one object, reusing released objects first
+void* slab_alloc(Slab* slab) {
+    void* object;
+    if (slab->free_list != NULL) {
+        object = slab->free_list;
+        slab->free_list = *(void**)object;
+    } else {
+        if (slab->bump_left == 0) {
+            slab_add_chunk(slab);
+        }
+        object = slab->bump;
+        slab->bump += slab->object_size;
+        slab->bump_left--;
+    }
+    slab->live++;
+    return object;
+}
+
+// Function to return an object to the slab's free list
+void slab_free(Slab* slab, void* object) {
+    *(void**)object = slab->free_list;
+    slab->free_list = object;
+    slab->live--;
+}
+
+// Function to release every chunk at once
+void slab_destroy(Slab* slab) {
+    for (size_t i = 0; i < slab->chunk_count; i++) {
+        free(slab->chunks[i]);
+    }
+    free(slab->chunks);
+    slab_init(slab, slab->object_size);
+}
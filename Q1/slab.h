@@ -0,0 +1,26 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+#define SLAB_CHUNK_OBJECTS 1024 // Objects carved from each chunk allocation
+
+// Fixed-size object allocator backed by large chunks with an intrusive free list
+typedef struct {
+    size_t object_size;             // Bytes per object (at least sizeof(void*))
+    void** chunks;                  // Every chunk allocated so far
+    size_t chunk_count;             // Number of chunks in use
+    size_t chunk_capacity;          // Allocated entries in chunks
+    char* bump;                     // Next never-used object in the newest chunk
+    size_t bump_left;               // Objects left after bump in the newest chunk
+    void* free_list;                // Released objects, linked through their first word
+    size_t live;                    // Objects currently handed out
+} Slab;
+
+// Function prototypes
+void slab_init(Slab* slab, size_t object_size);
+void* slab_alloc(Slab* slab);
+void slab_free(Slab* slab, void* object);
+void slab_destroy(Slab* slab);
+
+#endif
@@ -1,7 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <openssl/sha.h>
 #include "block.h"
+#include "chain_file.h"
+#include "job_import.h"
+#include "job_render.h"
+#include "job_server.h"
 
 // Function prototypes
 void test_add_job();
@@ -9,11 +19,26 @@ void test_list_jobs();
 void test_modify_job();
 void test_delete_job();
 void test_integrity_verification();
+void test_job_index();
+void test_keyword_search();
+void test_block_storage();
+void test_chain_file();
+void test_full_verification();
+void test_lazy_rehash();
+void test_block_hashing();
+void test_bulk_import();
+void test_render_jobs();
+void test_tombstone_compaction();
+void test_facet_filter();
+void test_merkle_tree();
+void test_query_server();
+void test_metrics();
 
-Block* blockchain; // Global variable to hold the blockchain for testing
+Blockchain blockchain; // Global variable to hold the blockchain for testing
+int failed_tests = 0;  // Tests that reported a failure; main returns non-zero if any did
 
 int main() {
-    blockchain = NULL; // Initialize the blockchain
+    initialize_blockchain(&blockchain); // Initialize the blockchain
     printf("Running tests for Blockchain Job Directory...\n");
 
     test_add_job();
@@ -21,8 +46,28 @@ int main() {
     test_modify_job();
     test_delete_job();
     test_integrity_verification();
+    test_job_index();
+    test_keyword_search();
+    test_block_storage();
+    test_chain_file();
+    test_full_verification();
+    test_lazy_rehash();
+    test_block_hashing();
+    test_bulk_import();
+    test_render_jobs();
+    test_tombstone_compaction();
+    test_facet_filter();
+    test_merkle_tree();
+    test_query_server();
+    test_metrics();
 
+    free_blockchain(&blockchain);
+    release_block_storage();
     printf("All tests completed.\n");
+    if (failed_tests > 0) {
+        printf("%d tests failed.\n", failed_tests);
+        return 1;
+    }
     return 0;
 }
 
@@ -32,7 +77,7 @@ void test_add_job() {
     Job job2 = {"J0002", "Data Scientist", "Data Inc", "San Francisco", "Analyze and interpret complex data."};
 
     // Add job 1
-    Block* block1 = create_block(job1, "0");
+    Block* block1 = create_block(job1, NULL);
     add_block(&blockchain, block1);
 
     // Add job 2
@@ -45,15 +90,16 @@ void test_add_job() {
 // Test listing jobs
 void test_list_jobs() {
     printf("\nTesting list jobs:\n");
-    list_jobs(blockchain);
+    list_jobs(&blockchain);
 }
 
 // Test modifying a job
 void test_modify_job() {
     printf("\nTesting modify job:\n");
-    if (modify_job(blockchain, "J0001")) {
+    if (modify_job(&blockchain, "J0001")) {
         printf("Job modified successfully.\n");
     } else {
+        failed_tests++;
         printf("Job modification failed.\n");
     }
 }
@@ -64,6 +110,7 @@ void test_delete_job() {
     if (delete_job(&blockchain, "J0002")) {
         printf("Job deleted successfully.\n");
     } else {
+        failed_tests++;
         printf("Job deletion failed.\n");
     }
 }
@@ -71,9 +118,935 @@ void test_delete_job() {
 // Test verifying the integrity of the blockchain
 void test_integrity_verification() {
     printf("\nTesting integrity verification:\n");
-    if (verify_integrity(blockchain)) {
+    if (verify_integrity(&blockchain)) {
         printf("Blockchain integrity verified. No tampering detected.\n");
     } else {
+        failed_tests++;
         printf("Blockchain integrity compromised!\n");
     }
 }
+
+// Test constant-time lookup, update and delete through the job ID index
+void test_job_index() {
+    printf("\nTesting job ID index:\n");
+    Blockchain chain;
+    initialize_blockchain(&chain);
+
+    char id[JOB_ID_LENGTH];
+    for (int i = 0; i < 1000; i++) {
+        Job job = {"", "Engineer", "Tech Corp", "Kigali", "Build things."};
+        snprintf(id, sizeof(id), "J%04d", i);
+        strcpy(job.id, id);
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+    }
+
+    int failures = 0;
+    for (int i = 0; i < 1000; i++) {
+        snprintf(id, sizeof(id), "J%04d", i);
+        Block* block = find_job(&chain, id);
+        if (block == NULL || block->index != i) {
+            failures++;
+        }
+    }
+
+    Job renamed = {"K0007", "Engineer", "Tech Corp", "Kigali", "Build things."};
+    if (!update_job(&chain, "J0007", &renamed) || find_job(&chain, "J0007") || !find_job(&chain, "K0007")) {
+        failures++;
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        snprintf(id, sizeof(id), "J%04d", i);
+        delete_job(&chain, id);
+    }
+    for (int i = 1; i < 1000; i += 2) {
+        snprintf(id, sizeof(id), "J%04d", i);
+        if (i != 7 && find_job(&chain, id) == NULL) {
+            failures++;
+        }
+    }
+    if (chain.count != 500 || chain.tail == NULL || chain.tail->index != 999) {
+        failures++;
+    }
+
+    if (failures == 0) {
+        printf("Job ID index test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Job ID index test failed (%d errors).\n", failures);
+    }
+    free_blockchain(&chain);
+}
+
+// Test AND/OR keyword queries, partial-word matching and index maintenance
+void test_keyword_search() {
+    printf("\nTesting keyword search:\n");
+    Blockchain chain;
+    initialize_blockchain(&chain);
+
+    Job jobs[] = {
+        {"S0001", "Senior Software Engineer", "Tech Corp", "Kigali", "Build backend services in C."},
+        {"S0002", "Data Engineer", "Data Inc", "Nairobi", "Maintain data pipelines."},
+        {"S0003", "Product Manager", "Biz Ltd", "Lagos", "Own the software roadmap."},
+    };
+    for (int i = 0; i < 3; i++) {
+        add_block(&chain, create_block(jobs[i], chain.tail ? chain.tail->hash : NULL));
+    }
+
+    PostingList results = {NULL, 0, 0};
+    int failures = 0;
+    if (search_jobs(&chain, "software", QUERY_ALL, &results) != 2) failures++;
+    if (search_jobs(&chain, "Engineer software", QUERY_ALL, &results) != 1 || results.positions[0] != 0) failures++;
+    if (search_jobs(&chain, "pipelines roadmap", QUERY_ANY, &results) != 2) failures++;
+    if (search_jobs(&chain, "Soft", QUERY_ALL, &results) != 2) failures++; // Part of "Software"
+    if (search_jobs(&chain, "engine pipe", QUERY_ALL, &results) != 1 || results.positions[0] != 1) failures++;
+
+    // A partial word that is also a whole word elsewhere matches both, whatever is indexed
+    Job coach = {"S0004", "Soft skills coach", "Biz Ltd", "Lagos", "Coach teams."};
+    add_block(&chain, create_block(coach, chain.tail->hash));
+    if (search_jobs(&chain, "Soft", QUERY_ALL, &results) != 3 || results.positions[2] != 3) failures++;
+    if (search_jobs(&chain, "Softw", QUERY_ALL, &results) != 2 || results.positions[1] != 2) failures++;
+    strcpy(coach.title, "Skills coach");
+    update_job(&chain, "S0004", &coach);
+    if (search_jobs(&chain, "Soft", QUERY_ALL, &results) != 2) failures++;
+    if (keyword_index_lookup(&chain.keywords, "soft") != NULL) failures++; // Emptied terms leave the table
+
+    // Words too long to index are still found, whole or in part
+    Job long_word = {"S0005", "Pneumonoultramicroscopicsilicovolcanoconiosis researcher", "Lab", "Lagos", "Study dust."};
+    add_block(&chain, create_block(long_word, chain.tail->hash));
+    if (search_jobs(&chain, "volcano", QUERY_ALL, &results) != 1 || results.positions[0] != 4) failures++;
+    if (search_jobs(&chain, "Pneumonoultramicroscopicsilicovolcano", QUERY_ALL, &results) != 1) failures++;
+    if (search_jobs(&chain, "volcano dust", QUERY_ALL, &results) != 1) failures++;
+
+    Job renamed = jobs[1];
+    strcpy(renamed.title, "Data Analyst");
+    update_job(&chain, "S0002", &renamed);
+    if (search_jobs(&chain, "engineer", QUERY_ALL, &results) != 1) failures++;
+    if (search_jobs(&chain, "analyst", QUERY_ALL, &results) != 1) failures++;
+
+    delete_job(&chain, "S0001");
+    if (search_jobs(&chain, "software", QUERY_ALL, &results) != 1 || results.positions[0] != 2) failures++;
+
+    // Removing terms keeps the rest of their probe runs reachable
+    KeywordIndex index;
+    keyword_index_init(&index);
+    char word[16];
+    for (int i = 0; i < 500; i++) {
+        snprintf(word, sizeof(word), "w%d", i);
+        keyword_index_add(&index, i, word);
+    }
+    for (int i = 0; i < 500; i += 2) {
+        snprintf(word, sizeof(word), "w%d", i);
+        keyword_index_remove(&index, i, word);
+    }
+    for (int i = 0; i < 500; i++) {
+        snprintf(word, sizeof(word), "w%d", i);
+        const PostingList* postings = keyword_index_lookup(&index, word);
+        if ((i % 2 == 0) != (postings == NULL) || (postings != NULL && postings->positions[0] != i)) failures++;
+    }
+    if (index.used != 250) failures++;
+    keyword_index_free(&index);
+
+    if (failures == 0) {
+        printf("Keyword search test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Keyword search test failed (%d errors).\n", failures);
+    }
+    posting_list_free(&results);
+    free_blockchain(&chain);
+}
+
+// Test that deleted blocks are recycled by the block storage free list
+void test_block_storage() {
+    printf("\nTesting block storage reuse:\n");
+    Blockchain chain;
+    initialize_blockchain(&chain);
+
+    Job job = {"B0001", "Engineer", "Tech Corp", "Kigali", "Build things."};
+    add_block(&chain, create_block(job, NULL));
+    Block* deleted = chain.tail;
+    JobText* deleted_text = deleted->text;
+    delete_job(&chain, "B0001");
+    compact_blockchain(&chain); // Tombstoned blocks are reclaimed by compaction
+
+    strcpy(job.id, "B0002");
+    Block* reused = create_block(job, NULL);
+    add_block(&chain, reused);
+
+    Job copy;
+    get_job(reused, &copy);
+    if (reused == deleted && reused->text == deleted_text && strcmp(copy.id, "B0002") == 0 &&
+        strcmp(copy.title, "Engineer") == 0) {
+        printf("Block storage reuse test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Block storage reuse test failed.\n");
+    }
+    free_blockchain(&chain);
+}
+
+// Test that a chain written to a chain file is restored on reopen
+void test_chain_file() {
+    printf("\nTesting chain file persistence:\n");
+    const char* path = "test_chain_file.dat";
+    remove(path);
+
+    Blockchain chain;
+    ChainFile file;
+    initialize_blockchain(&chain);
+    if (chain_file_open(&file, path, &chain) != 0) {
+        failed_tests++;
+        printf("Chain file test failed (cannot create file).\n");
+        return;
+    }
+    Job jobs[] = {
+        {"F0001", "Software Engineer", "Tech Corp", "Kigali", "Write C code."},
+        {"F0002", "Data Engineer", "Data Inc", "Nairobi", "Maintain pipelines."},
+        {"F0003", "Product Manager", "Biz Ltd", "Lagos", "Own the roadmap."},
+    };
+    for (int i = 0; i < 3; i++) {
+        add_block(&chain, create_block(jobs[i], chain.tail ? chain.tail->hash : NULL));
+    }
+    Job edited = jobs[0];
+    strcpy(edited.description, "Write and review C code.");
+    update_job(&chain, "F0001", &edited);
+    delete_job(&chain, "F0002");
+    unsigned char tail_hash[DIGEST_LENGTH];
+    memcpy(tail_hash, chain.tail->hash, DIGEST_LENGTH);
+    free_blockchain(&chain);
+    chain_file_close(&file);
+
+    initialize_blockchain(&chain);
+    int failures = 0;
+    if (chain_file_open(&file, path, &chain) != 0) {
+        failures++;
+    } else {
+        Block* block = find_job(&chain, "F0001");
+        if (chain.count != 2 || find_job(&chain, "F0002") != NULL || block == NULL) failures++;
+        if (block != NULL && strcmp(block->text->description, "Write and review C code.") != 0) failures++;
+        if (chain.tail == NULL || memcmp(chain.tail->hash, tail_hash, DIGEST_LENGTH) != 0 || chain.next_index != 3) failures++;
+        PostingList results = {NULL, 0, 0};
+        if (search_jobs(&chain, "roadmap", QUERY_ALL, &results) != 1) failures++;
+        posting_list_free(&results);
+
+        // Appends after a reload go to the end of the same file
+        add_block(&chain, create_block(jobs[1], chain.tail->hash));
+        free_blockchain(&chain);
+        chain_file_close(&file);
+        initialize_blockchain(&chain);
+        if (chain_file_open(&file, path, &chain) != 0 || chain.count != 3 || chain.tail->index != 3) failures++;
+
+        // A failed write marks the file stale instead of leaving a gap; recovery rewrites it
+        close(file.fd);
+        file.fd = open("/dev/full", O_WRONLY);
+        Job late = {"F0004", "QA Engineer", "Test Co", "Accra", "Break things."};
+        add_block(&chain, create_block(late, chain.tail->hash));
+        if (!file.stale) failures++;
+        delete_job(&chain, "F0003");
+        if (chain_file_recover(&file, &chain) != 0 || file.stale) failures++;
+        free_blockchain(&chain);
+        chain_file_close(&file);
+        initialize_blockchain(&chain);
+        if (chain_file_open(&file, path, &chain) != 0) {
+            failures++;
+        } else {
+            if (chain.count != 3 || chain.next_index != 5 || find_job(&chain, "F0003") != NULL ||
+                find_job(&chain, "F0004") == NULL) failures++;
+            free_blockchain(&chain);
+            chain_file_close(&file);
+        }
+    }
+    remove(path);
+
+    if (failures == 0) {
+        printf("Chain file test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Chain file test failed (%d errors).\n", failures);
+    }
+}
+
+// Test that full re-hash verification catches tampered job text and that
+// incremental checks only re-hash blocks added since the last check
+void test_full_verification() {
+    printf("\nTesting full and incremental verification:\n");
+    Blockchain chain;
+    initialize_blockchain(&chain);
+    for (int i = 0; i < 20000; i++) {
+        Job job = {"", "Engineer", "Tech Corp", "Kigali", "Build things."};
+        snprintf(job.id, sizeof(job.id), "V%04d", i % 10000);
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+    }
+
+    int failures = 0;
+    VerifyResult result;
+    if (!verify_chain(&chain, VERIFY_FULL, 4, &result) || result.rehashed != 20000) failures++;
+
+    Job job = {"V9999", "Engineer", "Tech Corp", "Kigali", "Build things."};
+    add_block(&chain, create_block(job, chain.tail->hash));
+    if (!verify_chain(&chain, VERIFY_INCREMENTAL, 4, &result) || result.rehashed != 1) failures++;
+
+    // Tamper with job text behind the chain's back: links still match, hashes do not
+    strcpy(chain.blocks[12345]->text->description, "Tampered.");
+    if (!verify_integrity(&chain)) failures++; // Incremental check has no reason to look there
+    if (verify_chain(&chain, VERIFY_FULL, 4, &result) || result.first_invalid != 12345) failures++;
+
+    if (failures == 0) {
+        printf("Verification test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Verification test failed (%d errors).\n", failures);
+    }
+    free_blockchain(&chain);
+}
+
+// Test that edits defer the cascading re-hash and a later verify repairs every link
+void test_lazy_rehash() {
+    printf("\nTesting lazy cascading re-hash:\n");
+    Blockchain chain;
+    initialize_blockchain(&chain);
+    for (int i = 0; i < 100; i++) {
+        Job job = {"", "Engineer", "Tech Corp", "Kigali", "Build things."};
+        snprintf(job.id, sizeof(job.id), "L%04d", i);
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+    }
+    unsigned char tail_hash[DIGEST_LENGTH];
+    memcpy(tail_hash, chain.tail->hash, DIGEST_LENGTH);
+
+    int failures = 0;
+    for (int i = 10; i < 60; i += 5) {
+        Job job = {"", "Senior Engineer", "Tech Corp", "Kigali", "Build more things."};
+        snprintf(job.id, sizeof(job.id), "L%04d", i);
+        update_job(&chain, job.id, &job);
+    }
+    delete_job(&chain, "L0070");
+    if (chain.dirty_from != 10 || memcmp(chain.tail->hash, tail_hash, DIGEST_LENGTH) != 0) failures++; // Nothing re-hashed yet
+
+    if (!verify_integrity(&chain) || chain.dirty_from != -1) failures++;
+    if (memcmp(chain.tail->hash, tail_hash, DIGEST_LENGTH) == 0) failures++;
+    // The deleted block stays linked as a tombstone until compaction
+    if (memcmp(find_job(&chain, "L0071")->previous_hash, chain.blocks[70]->hash, DIGEST_LENGTH) != 0) failures++;
+    compact_blockchain(&chain);
+    if (memcmp(find_job(&chain, "L0071")->previous_hash, find_job(&chain, "L0069")->hash, DIGEST_LENGTH) != 0) failures++;
+    if (!verify_chain(&chain, VERIFY_FULL, 1, NULL)) failures++;
+
+    if (failures == 0) {
+        printf("Lazy re-hash test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Lazy re-hash test failed (%d errors).\n", failures);
+    }
+    free_blockchain(&chain);
+}
+
+// Test that the streamed block hash equals SHA-256 over the concatenated fields
+// and that hex encoding matches printf formatting
+void test_block_hashing() {
+    printf("\nTesting block hashing:\n");
+    Job job = {"H0001", "Software Engineer", "Tech Corp", "Kigali", "Write C code."};
+    unsigned char previous[DIGEST_LENGTH];
+    for (int i = 0; i < DIGEST_LENGTH; i++) {
+        previous[i] = (unsigned char)(i * 37);
+    }
+    Block* block = create_block(job, previous);
+
+    unsigned char data[512];
+    size_t length = 0;
+    const char* fields[] = {job.title, job.company, job.location, job.description};
+    for (int i = 0; i < 4; i++) {
+        memcpy(data + length, fields[i], strlen(fields[i]));
+        length += strlen(fields[i]);
+    }
+    memcpy(data + length, previous, DIGEST_LENGTH);
+    length += DIGEST_LENGTH;
+    unsigned char expected[DIGEST_LENGTH];
+    SHA256(data, length, expected);
+
+    char hex[HASH_LENGTH], expected_hex[HASH_LENGTH];
+    hash_to_hex(block->hash, hex);
+    for (int i = 0; i < DIGEST_LENGTH; i++) {
+        sprintf(expected_hex + i * 2, "%02x", expected[i]);
+    }
+
+    if (memcmp(block->hash, expected, DIGEST_LENGTH) == 0 && strcmp(hex, expected_hex) == 0) {
+        printf("Block hashing test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Block hashing test failed.\n");
+    }
+    free_block(block);
+}
+
+// Test that CSV and JSONL imports build the same chain as adding each job by hand
+void test_bulk_import() {
+    printf("\nTesting bulk import:\n");
+    const char* csv_path = "test_import.csv";
+    const char* jsonl_path = "test_import.jsonl";
+    int failures = 0;
+
+    FILE* csv = fopen(csv_path, "w");
+    FILE* jsonl = fopen(jsonl_path, "w");
+    if (csv == NULL || jsonl == NULL) {
+        failed_tests++;
+        printf("Bulk import test failed (cannot create input files).\n");
+        return;
+    }
+    fprintf(csv, "id,title,company,location,description\n");
+    fprintf(csv, "I0000,\"Engineer, Backend\",Tech Corp,Kigali,\"Say \"\"hello\"\".\"\r\n");
+    fprintf(csv, "not a job\n");
+    fprintf(jsonl, "{\"id\": \"I0000\", \"title\": \"Engineer, Backend\", \"company\": \"Tech Corp\", "
+                   "\"location\": \"Kigali\", \"salary\": 100, \"description\": \"Say \\\"hello\\\".\"}\n");
+    fprintf(jsonl, "{\"id\": \"I0001\", \"title\": [\"nested\"]}\n");
+    for (int i = 1; i < 1000; i++) {
+        fprintf(csv, "I%04d,Engineer %d,Tech Corp,Kigali,Build things.\n", i, i);
+        fprintf(jsonl, "{\"id\":\"I%04d\",\"title\":\"Engineer %d\",\"company\":\"Tech Corp\","
+                       "\"location\":\"Kigali\",\"description\":\"Build things.\"}\n", i, i);
+    }
+    fclose(csv);
+    fclose(jsonl);
+
+    // Reference chain built one job at a time
+    Blockchain expected;
+    initialize_blockchain(&expected);
+    Job first = {"I0000", "Engineer, Backend", "Tech Corp", "Kigali", "Say \"hello\"."};
+    add_block(&expected, create_block(first, NULL));
+    for (int i = 1; i < 1000; i++) {
+        Job job = {"", "", "Tech Corp", "Kigali", "Build things."};
+        snprintf(job.id, sizeof(job.id), "I%04d", i);
+        snprintf(job.title, sizeof(job.title), "Engineer %d", i);
+        add_block(&expected, create_block(job, expected.tail->hash));
+    }
+
+    const char* paths[] = {csv_path, jsonl_path};
+    for (int p = 0; p < 2; p++) {
+        Blockchain chain;
+        ImportStats stats;
+        initialize_blockchain(&chain);
+        if (import_jobs(&chain, paths[p], IMPORT_AUTO, &stats) != 0) failures++;
+        if (stats.imported != 1000 || stats.skipped != 1 || chain.count != 1000) failures++;
+        if (memcmp(chain.tail->hash, expected.tail->hash, DIGEST_LENGTH) != 0) failures++;
+        Block* block = find_job(&chain, "I0000");
+        if (block == NULL || strcmp(block->text->description, "Say \"hello\".") != 0) failures++;
+
+        PostingList results = {NULL, 0, 0};
+        if (search_jobs(&chain, "backend", QUERY_ALL, &results) != 1) failures++;
+        posting_list_free(&results);
+        if (!verify_chain(&chain, VERIFY_FULL, 2, NULL)) failures++;
+        free_blockchain(&chain);
+    }
+    free_blockchain(&expected);
+    remove(csv_path);
+    remove(jsonl_path);
+
+    if (failures == 0) {
+        printf("Bulk import test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Bulk import test failed (%d errors).\n", failures);
+    }
+}
+
+// Render a page of jobs into a string (caller frees)
+static char* render_to_string(Blockchain* chain, const PostingList* positions, RenderFormat format, int offset, int limit) {
+    FILE* out = tmpfile();
+    render_jobs(chain, positions, out, format, offset, limit);
+    long size = ftell(out);
+    char* text = (char*)calloc((size_t)size + 1, 1);
+    rewind(out);
+    if (fread(text, 1, (size_t)size, out) != (size_t)size) {
+        text[0] = '\0';
+    }
+    fclose(out);
+    return text;
+}
+
+// Test text and JSONL rendering, timestamp formatting and pagination
+void test_render_jobs() {
+    printf("\nTesting job rendering:\n");
+    Blockchain chain;
+    initialize_blockchain(&chain);
+    for (int i = 0; i < 10; i++) {
+        Job job = {"", "Engineer", "Tech \"Quoted\" Corp", "Kigali", "Line one\nline two."};
+        snprintf(job.id, sizeof(job.id), "R%04d", i);
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+    }
+    int failures = 0;
+
+    // Text output keeps the interactive layout, with ctime timestamps
+    Block* first = chain.blocks[0];
+    first->timestamp = 1700000059; // Last second of a minute
+    chain.blocks[1]->timestamp = 1700000060;
+    char hash[HASH_LENGTH], expected[1024];
+    hash_to_hex(first->hash, hash);
+    snprintf(expected, sizeof(expected),
+             "Job ID: R0000\nTitle: Engineer\nCompany: Tech \"Quoted\" Corp\nLocation: Kigali\n"
+             "Description: Line one\nline two.\nTimestamp: %sHash: %s\nPrevious Hash: %064d\n--------------------\n",
+             ctime(&first->timestamp), hash, 0);
+    char* text = render_to_string(&chain, NULL, RENDER_TEXT, 0, 2);
+    if (strncmp(text, expected, strlen(expected)) != 0) failures++;
+    if (strstr(text + strlen(expected), ctime(&chain.blocks[1]->timestamp)) == NULL) failures++;
+    free(text);
+
+    // JSONL escapes strings and pages through the chain
+    text = render_to_string(&chain, NULL, RENDER_JSONL, 3, 4);
+    int lines = 0;
+    for (const char* p = text; *p; p++) {
+        lines += *p == '\n';
+    }
+    if (lines != 4 || strncmp(text, "{\"index\":3,\"id\":\"R0003\",", 24) != 0) failures++;
+    if (strstr(text, "\"company\":\"Tech \\\"Quoted\\\" Corp\"") == NULL) failures++;
+    if (strstr(text, "\"description\":\"Line one\\nline two.\"") == NULL) failures++;
+    free(text);
+
+    // Pages of search results, and past the end after a deletion
+    PostingList results = {NULL, 0, 0};
+    search_jobs(&chain, "engineer", QUERY_ALL, &results);
+    text = render_to_string(&chain, &results, RENDER_JSONL, 8, 5);
+    if (strncmp(text, "{\"index\":8,", 11) != 0 || strstr(text, "\"index\":9,") == NULL) failures++;
+    free(text);
+    posting_list_free(&results);
+    delete_job(&chain, "R0002");
+    text = render_to_string(&chain, NULL, RENDER_JSONL, 2, 1);
+    if (strncmp(text, "{\"index\":3,", 11) != 0) failures++;
+    free(text);
+    text = render_to_string(&chain, NULL, RENDER_JSONL, 9, 0);
+    if (text[0] != '\0') failures++;
+    free(text);
+
+    if (failures == 0) {
+        printf("Rendering test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Rendering test failed (%d errors).\n", failures);
+    }
+    free_blockchain(&chain);
+}
+
+// Test that deletes leave the chain verifiable and compaction relinks, re-hashes
+// and rewrites the chain file
+void test_tombstone_compaction() {
+    printf("\nTesting tombstone deletes and compaction:\n");
+    const char* path = "test_compaction.dat";
+    remove(path);
+    Blockchain chain;
+    ChainFile file;
+    int failures = 0;
+
+    initialize_blockchain(&chain);
+    if (chain_file_open(&file, path, &chain) != 0) {
+        failed_tests++;
+        printf("Compaction test failed (cannot create file).\n");
+        return;
+    }
+    for (int i = 0; i < 100; i++) {
+        Job job = {"", "Engineer", "Tech Corp", "Kigali", ""};
+        snprintf(job.id, sizeof(job.id), "T%04d", i);
+        strcpy(job.description, i % 2 ? "Odd job." : "Even job.");
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+    }
+    unsigned char tail_hash[DIGEST_LENGTH];
+    memcpy(tail_hash, chain.tail->hash, DIGEST_LENGTH);
+
+    // Delete every third job: nothing is re-hashed and the chain still verifies
+    for (int i = 0; i < 100; i += 3) {
+        char id[JOB_ID_LENGTH];
+        snprintf(id, sizeof(id), "T%04d", i);
+        if (!delete_job(&chain, id)) failures++;
+    }
+    if (chain.count != 66 || chain.tombstones != 34 || find_job(&chain, "T0003") != NULL) failures++;
+    if (chain.dirty_from != -1 || memcmp(chain.tail->hash, tail_hash, DIGEST_LENGTH) != 0) failures++;
+    if (!verify_chain(&chain, VERIFY_FULL, 1, NULL)) failures++;
+    PostingList results = {NULL, 0, 0};
+    if (search_jobs(&chain, "even", QUERY_ALL, &results) != 33 || search_jobs(&chain, "job", QUERY_ALL, &results) != 66) failures++;
+
+    // Compaction drops the tombstones, renumbers and relinks the survivors
+    if (compact_blockchain(&chain) != 34 || chain.count != 66 || chain.next_index != 66 || chain.tombstones != 0) failures++;
+    if (!verify_chain(&chain, VERIFY_FULL, 1, NULL)) failures++;
+    Block* block = find_job(&chain, "T0004");
+    if (block == NULL || block->index != 2 || memcmp(block->previous_hash, chain.blocks[1]->hash, DIGEST_LENGTH) != 0) failures++;
+    if (search_jobs(&chain, "odd", QUERY_ALL, &results) != 33 || chain.blocks[results.positions[0]] != find_job(&chain, "T0001")) failures++;
+    posting_list_free(&results);
+
+    // The rewritten file holds only the survivors and takes later changes
+    Job job = {"T0004", "Staff Engineer", "Tech Corp", "Kigali", "Even job."};
+    update_job(&chain, "T0004", &job);
+    rehash_pending(&chain);
+    memcpy(tail_hash, chain.tail->hash, DIGEST_LENGTH);
+    free_blockchain(&chain);
+    chain_file_close(&file);
+    initialize_blockchain(&chain);
+    // 66 jobs, the update and one STRING record each for the company and location
+    if (chain_file_open(&file, path, &chain) != 0 || file.records != 69 || chain.count != 66) failures++;
+    block = find_job(&chain, "T0004");
+    if (block == NULL || strcmp(block->text->title, "Staff Engineer") != 0) failures++;
+    rehash_pending(&chain);
+    if (chain.tail == NULL || memcmp(chain.tail->hash, tail_hash, DIGEST_LENGTH) != 0) failures++;
+    free_blockchain(&chain);
+    chain_file_close(&file);
+    remove(path);
+
+    // A chain whose only job is tombstoned still has a head but lists as empty
+    initialize_blockchain(&chain);
+    Job only = {"T9999", "Engineer", "Tech Corp", "Kigali", "Only job."};
+    add_block(&chain, create_block(only, NULL));
+    delete_job(&chain, "T9999");
+    FILE* listing = tmpfile();
+    char text[64] = "";
+    if (listing == NULL || chain.head == NULL) {
+        failures++;
+    } else {
+        fflush(stdout);
+        int saved = dup(STDOUT_FILENO);
+        dup2(fileno(listing), STDOUT_FILENO);
+        list_jobs(&chain);
+        fflush(stdout);
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        rewind(listing);
+        size_t length = fread(text, 1, sizeof(text) - 1, listing);
+        text[length] = '\0';
+        if (strcmp(text, "No job listings available.\n") != 0) failures++;
+    }
+    if (listing != NULL) {
+        fclose(listing);
+    }
+    free_blockchain(&chain);
+
+    if (failures == 0) {
+        printf("Compaction test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Compaction test failed (%d errors).\n", failures);
+    }
+}
+
+// Test interned companies and locations and faceted queries
+void test_facet_filter() {
+    printf("\nTesting faceted filtering:\n");
+    const char* companies[] = {"Tech Corp", "Data Inc", "Cloud Ltd"};
+    const char* locations[] = {"Kigali", "Nairobi"};
+    Blockchain chain;
+    initialize_blockchain(&chain);
+    for (int i = 0; i < 60; i++) {
+        Job job = {"", "", "", "", "Build things."};
+        snprintf(job.id, sizeof(job.id), "C%04d", i);
+        snprintf(job.title, sizeof(job.title), "%s", i % 4 ? "Engineer" : "Designer");
+        snprintf(job.company, sizeof(job.company), "%s", companies[i % 3]);
+        snprintf(job.location, sizeof(job.location), "%s", locations[i % 2]);
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+    }
+    int failures = 0;
+
+    // Every block shares one copy of each value
+    if (chain.blocks[0]->company != chain.blocks[3]->company || chain.blocks[0]->company == chain.blocks[1]->company) failures++;
+    if (strcmp(job_string(chain.blocks[4]->location), "Kigali") != 0) failures++;
+
+    PostingList results = {NULL, 0, 0};
+    if (filter_jobs(&chain, NULL, QUERY_ALL, "Data Inc", NULL, &results) != 20 || results.positions[0] != 1) failures++;
+    if (filter_jobs(&chain, NULL, QUERY_ALL, "Tech Corp", "Nairobi", &results) != 10 || results.positions[0] != 3) failures++;
+    if (filter_jobs(&chain, "designer", QUERY_ALL, "Tech Corp", "Kigali", &results) != 5) failures++; // i % 12 == 0
+    if (filter_jobs(&chain, NULL, QUERY_ALL, "Unknown Co", NULL, &results) != 0) failures++;
+    if (filter_jobs(&chain, NULL, QUERY_ALL, NULL, "", &results) != 60) failures++;
+
+    // Edits and deletes keep the code columns in step
+    Job job = {"C0001", "Engineer", "Tech Corp", "Kigali", "Build things."};
+    update_job(&chain, "C0001", &job);
+    delete_job(&chain, "C0000");
+    if (filter_jobs(&chain, NULL, QUERY_ALL, "Tech Corp", "Kigali", &results) != 10 || results.positions[0] != 1) failures++;
+    Job copy;
+    get_job(find_job(&chain, "C0002"), &copy);
+    if (strcmp(copy.company, "Cloud Ltd") != 0 || strcmp(copy.location, "Kigali") != 0) failures++;
+    compact_blockchain(&chain);
+    if (filter_jobs(&chain, NULL, QUERY_ALL, "Tech Corp", "Kigali", &results) != 10 || results.positions[0] != 0) failures++;
+    if (!verify_chain(&chain, VERIFY_FULL, 1, NULL)) failures++;
+    posting_list_free(&results);
+
+    if (failures == 0) {
+        printf("Faceted filter test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Faceted filter test failed (%d errors).\n", failures);
+    }
+    free_blockchain(&chain);
+}
+
+// Reference RFC 6962 Merkle tree hash over block hashes, computed from scratch
+static void naive_merkle_hash(Blockchain* chain, int begin, int end, unsigned char out[MERKLE_HASH_LENGTH]) {
+    if (end - begin == 1) {
+        merkle_leaf_hash(chain->blocks[begin]->hash, out);
+        return;
+    }
+    int split = 1;
+    while (split * 2 < end - begin) {
+        split *= 2;
+    }
+    unsigned char node[1 + 2 * MERKLE_HASH_LENGTH];
+    node[0] = 0x01;
+    naive_merkle_hash(chain, begin, begin + split, node + 1);
+    naive_merkle_hash(chain, begin + split, end, node + 1 + MERKLE_HASH_LENGTH);
+    SHA256(node, sizeof(node), out);
+}
+
+// Test Merkle roots, inclusion proofs and range verification as the chain grows and changes
+void test_merkle_tree() {
+    printf("\nTesting Merkle tree:\n");
+    Blockchain chain;
+    initialize_blockchain(&chain);
+    unsigned char root[MERKLE_HASH_LENGTH], expected[MERKLE_HASH_LENGTH];
+    MerkleProof proof;
+    int failures = 0;
+
+    // Roots and every proof match the reference at each size, including uneven ones
+    for (int i = 0; i < 70; i++) {
+        Job job = {"", "Engineer", "Tech Corp", "Kigali", "Build things."};
+        snprintf(job.id, sizeof(job.id), "M%04d", i);
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+        merkle_root_hash(&chain, root);
+        naive_merkle_hash(&chain, 0, chain.next_index, expected);
+        if (memcmp(root, expected, MERKLE_HASH_LENGTH) != 0) failures++;
+        for (int j = 0; j <= i; j++) {
+            if (!merkle_prove(&chain.merkle, (size_t)j, &proof) ||
+                !merkle_verify_proof(chain.blocks[j]->hash, &proof, root)) failures++;
+        }
+    }
+
+    // A proof fails for another block, a changed path, or a different root
+    if (!prove_job(&chain, "M0042", &proof, root) || proof.index != 42 || proof.length != 7) failures++;
+    if (!merkle_verify_proof(find_job(&chain, "M0042")->hash, &proof, root)) failures++;
+    if (merkle_verify_proof(find_job(&chain, "M0043")->hash, &proof, root)) failures++;
+    proof.path[3][0] ^= 1;
+    if (merkle_verify_proof(find_job(&chain, "M0042")->hash, &proof, root)) failures++;
+    if (prove_job(&chain, "NONE0", &proof, root)) failures++;
+
+    // Edits move the root; range checks see tampering only inside their range
+    unsigned char published[MERKLE_HASH_LENGTH];
+    merkle_root_hash(&chain, published);
+    Job job = {"M0010", "Senior Engineer", "Tech Corp", "Kigali", "Build more things."};
+    update_job(&chain, "M0010", &job);
+    merkle_root_hash(&chain, root);
+    naive_merkle_hash(&chain, 0, chain.next_index, expected);
+    if (memcmp(root, published, MERKLE_HASH_LENGTH) == 0 || memcmp(root, expected, MERKLE_HASH_LENGTH) != 0) failures++;
+    if (verify_block_range(&chain, 0, 70, NULL) != 1 || verify_block_range(&chain, 5, 5, NULL) != -1) failures++;
+    if (verify_block_range(&chain, 20, 40, published) != 0) failures++; // Re-hashed after the edit
+
+    strcpy(chain.blocks[30]->text->description, "Tampered.");
+    if (verify_block_range(&chain, 20, 40, NULL) != 0 || verify_block_range(&chain, 29, 31, root) != 0) failures++;
+    if (verify_block_range(&chain, 0, 30, NULL) != 1 || verify_block_range(&chain, 31, 70, root) != 1) failures++;
+    strcpy(chain.blocks[30]->text->description, "Build things.");
+
+    // Deletes keep tombstones as leaves; compaction shrinks the tree
+    delete_job(&chain, "M0000");
+    merkle_root_hash(&chain, expected);
+    if (memcmp(root, expected, MERKLE_HASH_LENGTH) != 0) failures++;
+    compact_blockchain(&chain);
+    merkle_root_hash(&chain, root);
+    naive_merkle_hash(&chain, 0, chain.next_index, expected);
+    if (chain.merkle.leaves != 69 || memcmp(root, expected, MERKLE_HASH_LENGTH) != 0) failures++;
+    if (verify_block_range(&chain, 0, 69, NULL) != 1) failures++;
+
+    if (failures == 0) {
+        printf("Merkle tree test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Merkle tree test failed (%d errors).\n", failures);
+    }
+    free_blockchain(&chain);
+}
+
+// A connection to the query server
+typedef struct {
+    FILE* in;
+    FILE* out;
+} ServerClient;
+
+// Connect to a query server socket; returns 0 on success
+static int client_open(ServerClient* client, const char* path) {
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        return -1;
+    }
+    client->out = fdopen(fd, "w");
+    client->in = fdopen(dup(fd), "r");
+    return 0;
+}
+
+static void client_close(ServerClient* client) {
+    fclose(client->out);
+    fclose(client->in);
+}
+
+// Send one command and read its reply; returns the OK value (-1 for ERR)
+// indexes (if not NULL) receives the "index" of each job line, up to max.
+static int client_request(ServerClient* client, const char* command, int* indexes, int max, int* jobs) {
+    char line[4096];
+    fprintf(client->out, "%s\n", command);
+    fflush(client->out);
+    *jobs = 0;
+    while (fgets(line, sizeof(line), client->in) != NULL) {
+        if (line[0] == '{') {
+            if (indexes != NULL && *jobs < max) {
+                indexes[*jobs] = atoi(line + strlen("{\"index\":"));
+            }
+            (*jobs)++;
+        } else if (strncmp(line, "OK ", 3) == 0) {
+            return atoi(line + 3);
+        } else {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+// Append jobs through the server from another connection
+static void* add_jobs_through_server(void* arg) {
+    ServerClient client;
+    int jobs, failures = 0;
+    if (client_open(&client, (const char*)arg) != 0) {
+        return (void*)1;
+    }
+    for (int i = 100; i < 400; i++) {
+        char command[256];
+        snprintf(command, sizeof(command), "ADD {\"id\":\"W%04d\",\"title\":\"Engineer %d\",\"company\":\"Tech Corp\","
+                 "\"location\":\"Kigali\",\"description\":\"Serve queries.\"}", i, i);
+        if (client_request(&client, command, NULL, 0, &jobs) != i) {
+            failures++;
+        }
+    }
+    client_close(&client);
+    return (void*)(long)failures;
+}
+
+// Test that readers see consistent snapshots while the writer appends
+void test_query_server() {
+    printf("\nTesting query server:\n");
+    const char* path = "test_server.sock";
+    Blockchain chain;
+    QueryServer server;
+    initialize_blockchain(&chain);
+    for (int i = 0; i < 100; i++) {
+        Job job = {"", "", "Tech Corp", "Kigali", "Serve queries."};
+        snprintf(job.id, sizeof(job.id), "W%04d", i);
+        snprintf(job.title, sizeof(job.title), "Engineer %d", i);
+        add_block(&chain, create_block(job, chain.tail ? chain.tail->hash : NULL));
+    }
+    if (server_start(&server, &chain, path, 4) != 0) {
+        failed_tests++;
+        printf("Query server test failed (cannot listen).\n");
+        free_blockchain(&chain);
+        return;
+    }
+
+    int failures = 0;
+    ServerClient client, idle[5];
+    for (int i = 0; i < 5; i++) {
+        if (client_open(&idle[i], path) != 0) failures++; // More idle clients than readers
+    }
+    if (client_open(&client, path) != 0) {
+        failures++;
+    } else {
+        pthread_t writer;
+        pthread_create(&writer, NULL, add_jobs_through_server, (void*)path);
+
+        // Every job matches, so each answer must be exactly a prefix of the chain
+        int* indexes = (int*)malloc(400 * sizeof(int));
+        int previous = 0, jobs;
+        for (int query = 0; query < 200; query++) {
+            int found = client_request(&client, "SEARCH engineer", indexes, 400, &jobs);
+            if (found != jobs || found < previous || found > 400) failures++;
+            for (int i = 0; i < jobs && i < 400; i++) {
+                if (indexes[i] != i) {
+                    failures++;
+                    break;
+                }
+            }
+            previous = found;
+        }
+        void* writer_failures;
+        pthread_join(writer, &writer_failures);
+        failures += (int)(long)writer_failures;
+        free(indexes);
+
+        int index;
+        if (client_request(&client, "COUNT", NULL, 0, &jobs) != 400) failures++;
+        if (client_request(&client, "GET W0399", &index, 1, &jobs) != 1 || index != 399) failures++;
+        if (client_request(&client, "SEARCH engineer 250", &index, 1, &jobs) != 1 || index != 250) failures++;
+        if (client_request(&client, "SEARCH queri", NULL, 0, &jobs) != 400) failures++; // Part of "queries", like search_jobs
+        if (client_request(&client, "LIST 398 5", &index, 1, &jobs) != 2 || index != 398) failures++;
+        if (client_request(&client, "ADD {\"id\": \"W9999\", \"title\": [\"nested\"]}", NULL, 0, &jobs) != -1) failures++;
+        if (client_request(&client, "DROP", NULL, 0, &jobs) != -1) failures++;
+        if (client_request(&idle[4], "COUNT", NULL, 0, &jobs) != 400) failures++;
+        client_close(&client);
+    }
+    for (int i = 0; i < 5; i++) {
+        client_close(&idle[i]);
+    }
+    server_stop(&server);
+
+    // The writer's appends are ordinary chain appends
+    if (chain.count != 400 || find_job(&chain, "W0321") == NULL || !verify_chain(&chain, VERIFY_FULL, 1, NULL)) failures++;
+    PostingList results = {NULL, 0, 0};
+    if (search_jobs(&chain, "engineer", QUERY_ALL, &results) != 400) failures++;
+    posting_list_free(&results);
+
+    if (failures == 0) {
+        printf("Query server test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Query server test failed (%d errors).\n", failures);
+    }
+    free_blockchain(&chain);
+}
+
+#define TEST_METRIC (METRICS_MAX_OPERATIONS - 1) // Unused by the chain, so its counts are ours alone
+
+// Record latencies of 1..1000 us from a worker thread
+static void* record_latencies(void* arg) {
+    (void)arg;
+    for (uint64_t us = 1; us <= 1000; us++) {
+        metrics_record(TEST_METRIC, us * 1000);
+    }
+    return NULL;
+}
+
+// Test per-thread latency histograms and their aggregation
+void test_metrics() {
+    printf("\nTesting metrics:\n");
+    MetricsHistogram histogram;
+    pthread_t threads[4];
+    int failures = 0;
+
+    // Four threads record the same distribution; the totals add up exactly
+    for (int t = 0; t < 4; t++) {
+        pthread_create(&threads[t], NULL, record_latencies, NULL);
+    }
+    for (int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    metrics_collect(TEST_METRIC, &histogram);
+    if (histogram.count != 4000 || histogram.total_ns != 4 * 500500000ull || histogram.max_ns != 1000000) failures++;
+
+    // Percentiles land within one bucket (6.25%) of the true value
+    double expected[] = {0.50, 500000, 0.90, 900000, 0.99, 990000};
+    for (int i = 0; i < 6; i += 2) {
+        double value = (double)metrics_percentile(&histogram, expected[i]);
+        if (value < expected[i + 1] * 0.9375 || value > expected[i + 1] * 1.0625) failures++;
+    }
+    if (metrics_percentile(&histogram, 1.0) != 1000000) failures++;
+
+    // Exited threads' storage is reused, so their counts stay in the totals
+    record_latencies(NULL);
+    metrics_record(TEST_METRIC, 7);
+    metrics_collect(TEST_METRIC, &histogram);
+    if (histogram.count != 5001 || metrics_percentile(&histogram, 0.0001) != 7) failures++;
+    if (metrics_percentile(&histogram, 0.5) > 1000000) failures++;
+
+    if (failures == 0) {
+        printf("Metrics test passed.\n");
+    } else {
+        failed_tests++;
+        printf("Metrics test failed (%d errors).\n", failures);
+    }
+}
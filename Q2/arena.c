@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 16 // Enough for any field type stored in the arena
+
+// Function to initialize an empty arena
+void arena_init(Arena* arena) {
+    arena->chunks = NULL;
+    arena->reserved = 0;
+    arena->used = 0;
+}
+
+// Allocate a chunk of at least size usable bytes and make it the bump region
+static void arena_add_chunk(Arena* arena, size_t size) {
+    ArenaChunk* chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) {
+        fprintf(stderr, "Error: Memory allocation failed for arena chunk.\n");
+        exit(1);
+    }
+    chunk->next = arena->chunks;
+    chunk->size = size;
+    chunk->used = 0;
+    arena->chunks = chunk;
+    arena->reserved += sizeof(ArenaChunk) + size;
+}
+
+// Function to get size bytes, aligned to 16, that stay valid until arena_destroy
+// Requests larger than a chunk get a dedicated chunk, which is linked behind the
+// current one so the current chunk's free space is not abandoned.
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (size > ARENA_CHUNK_SIZE / 4) {
+        ArenaChunk* current = arena->chunks;
+        arena_add_chunk(arena, size);
+        ArenaChunk* dedicated = arena->chunks;
+        if (current != NULL) {
+            arena->chunks = current;
+            dedicated->next = current->next;
+            current->next = dedicated;
+        }
+        dedicated->used = size;
+        arena->used += size;
+        return dedicated->data;
+    }
+    if (arena->chunks == NULL || arena->chunks->size - arena->chunks->used < size) {
+        arena_add_chunk(arena, ARENA_CHUNK_SIZE);
+    }
+    void* memory = arena->chunks->data + arena->chunks->used;
+    arena->chunks->used += size;
+    arena->used += size;
+    return memory;
+}
+
+// Function to free every chunk of the arena
+void arena_destroy(Arena* arena) {
+    ArenaChunk* chunk = arena->chunks;
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena_init(arena);
+}
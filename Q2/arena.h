@@ -0,0 +1,27 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_CHUNK_SIZE (256 * 1024) // Bytes per chunk; larger requests get a chunk of their own
+
+// Bump allocator for data that lives as long as the blockchain: nothing is freed individually
+typedef struct ArenaChunk {
+    struct ArenaChunk* next; // Previously filled chunk
+    size_t size; // Usable bytes in data
+    size_t used; // Bytes handed out from data
+    _Alignas(16) unsigned char data[];
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk* chunks; // Newest chunk first
+    size_t reserved; // Bytes obtained from malloc, chunk headers included
+    size_t used; // Bytes handed out, alignment padding included
+} Arena;
+
+// Function prototypes
+void arena_init(Arena* arena);
+void* arena_alloc(Arena* arena, size_t size);
+void arena_destroy(Arena* arena);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <openssl/sha.h>
+
+// Structure to represent a transaction, stored with its details inline in the
+// chain's arena (or, for blocks loaded from the block file, in the file's mapping)
+typedef struct {
+    int id; // Unique identifier for the transaction
+    unsigned char hash_signature[SHA256_DIGEST_LENGTH]; // SHA-256 signature of the ID and details
+    uint32_t details_length; // Length of details in bytes, excluding the terminating NUL
+    char details[]; // Description of the transaction
+} Transaction;
+
+// Structure to represent a block in the blockchain
+typedef struct Block {
+    int index; // Position of the block in the blockchain
+    time_t creation_time; // Timestamp of when the block was created
+    Transaction** transactions; // Transactions in order (array in the chain's arena)
+    int transaction_count; // Current number of transactions in the block
+    int transaction_capacity; // Entries allocated in transactions
+    size_t transaction_bytes; // Size of the block's transactions, checked against the byte limit
+    unsigned char previous_block_hash[SHA256_DIGEST_LENGTH]; // Raw hash of the previous block (zeros for genesis)
+    unsigned char block_hash[SHA256_DIGEST_LENGTH]; // Raw hash of the current block's header
+    unsigned char transactions_root[SHA256_DIGEST_LENGTH]; // Merkle root of the signatures, committed in the header
+    uint32_t target; // Compact proof-of-work target the block hash must be below (committed in the header)
+    uint32_t nonce; // Random value used for mining
+    struct Block* next; // Pointer to the next block in the chain
+} Block;
+
+#endif
@@ -0,0 +1,363 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "block_file.h"
+
+_Static_assert(sizeof(BlockFileHeader) == 64, "block file header must stay 64 bytes");
+_Static_assert(sizeof(BlockIndex) == 64, "block index header must stay 64 bytes");
+_Static_assert(sizeof(BlockRecord) % BLOCK_FILE_ALIGNMENT == 0, "block records must stay 8-byte aligned");
+
+// What check_record reports for a record cut short by the end of the file
+static const char record_torn[] = "record runs past the end of the file";
+
+// Round a size up to the file's record alignment
+static uint64_t padded(uint64_t size) {
+    return (size + BLOCK_FILE_ALIGNMENT - 1) & ~(uint64_t)(BLOCK_FILE_ALIGNMENT - 1);
+}
+
+// Write the whole buffer at the current end of the file
+static int write_fully(int fd, const void* data, size_t size) {
+    const char* cursor = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0) {
+            return -1;
+        }
+        cursor += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+// Map the index file with room for capacity offsets, growing the file if needed
+// Read-only opens have no index file and keep the index in anonymous memory.
+static int map_index(BlockFile* file, size_t capacity) {
+    size_t size = sizeof(BlockIndex) + capacity * sizeof(uint64_t);
+    void* map;
+    if (file->index_fd < 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map != MAP_FAILED && file->index != NULL) {
+            memcpy(map, file->index, sizeof(BlockIndex) + file->index_capacity * sizeof(uint64_t));
+        }
+    } else if (ftruncate(file->index_fd, (off_t)size) == 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file->index_fd, 0);
+    } else {
+        return -1;
+    }
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    if (file->index != NULL) {
+        munmap(file->index, sizeof(BlockIndex) + file->index_capacity * sizeof(uint64_t));
+    }
+    file->index = (BlockIndex*)map;
+    file->index_capacity = capacity;
+    return 0;
+}
+
+// Add a block's offset to the index, growing the mapping by doubling
+static int index_block(BlockFile* file, uint64_t offset) {
+    if (file->index->count == file->index_capacity && map_index(file, file->index_capacity * 2) != 0) {
+        return -1;
+    }
+    file->index->offsets[file->index->count++] = offset;
+    return 0;
+}
+
+// Check whether a record that claims to run past the end of the file is a cut-short append
+// A crash mid-append leaves a prefix of the record, so its transactions must
+// still be running when the file ends. If they all fit before the end, the
+// length is wrong and the bytes after them are later records, not a torn tail.
+static int record_cut_short(const BlockRecord* record, uint64_t size) {
+    uint64_t offset = sizeof(BlockRecord);
+    for (uint32_t i = 0; i < record->transaction_count; i++) {
+        if (offset + sizeof(Transaction) > size) {
+            return 1;
+        }
+        const Transaction* transaction = (const Transaction*)((const char*)record + offset);
+        uint64_t length = sizeof(Transaction) + (uint64_t)transaction->details_length + 1;
+        if (length > record->length - offset) {
+            return 0; // Could not be part of this record even if it were whole
+        }
+        if (offset + length > size) {
+            return 1;
+        }
+        if (transaction->details[transaction->details_length] != '\0') {
+            return 0;
+        }
+        offset += padded(length);
+    }
+    return 0;
+}
+
+// Check that size bytes at record hold a complete block record for block index
+// Returns NULL if they do, otherwise what is wrong with the record (record_torn
+// only if it can be the cut-short last append).
+static const char* check_record(const BlockRecord* record, uint64_t size, size_t index) {
+    if (size < sizeof(BlockRecord)) {
+        return record_torn;
+    }
+    if (record->length < sizeof(BlockRecord) || record->length % BLOCK_FILE_ALIGNMENT != 0) {
+        return "record length is malformed";
+    }
+    if (record->index != (int32_t)index) {
+        return "record is out of sequence";
+    }
+    if (record->length > size) {
+        return record_cut_short(record, size) ? record_torn : "record length does not match its transactions";
+    }
+    size_t offset = sizeof(BlockRecord);
+    for (uint32_t i = 0; i < record->transaction_count; i++) {
+        if (block_record_transaction(record, &offset) == NULL) {
+            return "record holds a malformed transaction";
+        }
+    }
+    return offset == record->length ? NULL : "record length does not match its transactions";
+}
+
+// Function to open (or create) a block file and its index at path and path.index
+// Blocks present at open are mapped read-only and stay valid until the file is
+// closed. Every record is checked for completeness and sequence. The index
+// only caches where each record starts: if it is missing, damaged or behind
+// the block file (a crash between the two writes), it is rebuilt from the
+// records. A torn record at the end is dropped; a damaged one anywhere else
+// fails the open. With read_only set, neither file is created or changed: the
+// index is rebuilt in memory, loading stops at the first damaged or torn
+// record and file->damage says what is wrong with it. Returns 0 on success,
+// -1 on error.
+int block_file_open(BlockFile* file, const char* path, int read_only) {
+    size_t path_length = strlen(path);
+    char* index_path = (char*)malloc(path_length + sizeof(".index"));
+    struct stat info;
+
+    if (!index_path) {
+        fprintf(stderr, "Error: Memory allocation failed for block file path.\n");
+        exit(1);
+    }
+    memcpy(index_path, path, path_length);
+    memcpy(index_path + path_length, ".index", sizeof(".index"));
+    file->map = NULL;
+    file->map_size = 0;
+    file->index = NULL;
+    file->index_capacity = 0;
+    file->index_fd = -1;
+    file->index_stale = 0;
+    file->failed = read_only;
+    file->damage = NULL;
+    file->fd = read_only ? open(path, O_RDONLY) : open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (file->fd < 0 || fstat(file->fd, &info) != 0) {
+        fprintf(stderr, "Error: Unable to open block file '%s'.\n", path);
+        free(index_path);
+        block_file_close(file);
+        return -1;
+    }
+
+    if (info.st_size == 0 && !read_only) {
+        BlockFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, BLOCK_FILE_MAGIC, sizeof(header.magic));
+        header.version = BLOCK_FILE_VERSION;
+        header.record_size = sizeof(BlockRecord);
+        header.transaction_size = sizeof(Transaction);
+        if (write_fully(file->fd, &header, sizeof(header)) != 0 || fsync(file->fd) != 0) {
+            fprintf(stderr, "Error: Unable to initialize block file '%s'.\n", path);
+            free(index_path);
+            block_file_close(file);
+            return -1;
+        }
+        info.st_size = sizeof(header);
+    }
+
+    file->map_size = (size_t)info.st_size;
+    file->map = file->map_size > 0 ? mmap(NULL, file->map_size, PROT_READ, MAP_SHARED, file->fd, 0) : MAP_FAILED;
+    const BlockFileHeader* header = (const BlockFileHeader*)file->map;
+    if (file->map == MAP_FAILED || file->map_size < sizeof(BlockFileHeader) ||
+        memcmp(header->magic, BLOCK_FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != BLOCK_FILE_VERSION ||
+        header->record_size != sizeof(BlockRecord) || header->transaction_size != sizeof(Transaction)) {
+        fprintf(stderr, "Error: '%s' is not a compatible block file.\n", path);
+        if (file->map == MAP_FAILED) {
+            file->map = NULL;
+        }
+        free(index_path);
+        block_file_close(file);
+        return -1;
+    }
+
+    // Open the index; a new, damaged or foreign one is rebuilt from scratch
+    info.st_size = 0;
+    if (!read_only && ((file->index_fd = open(index_path, O_RDWR | O_CREAT, 0644)) < 0 ||
+                       fstat(file->index_fd, &info) != 0)) {
+        fprintf(stderr, "Error: Unable to open block index '%s'.\n", index_path);
+        free(index_path);
+        block_file_close(file);
+        return -1;
+    }
+    size_t capacity = info.st_size > (off_t)sizeof(BlockIndex)
+                          ? ((size_t)info.st_size - sizeof(BlockIndex)) / sizeof(uint64_t) : 0;
+    if (map_index(file, capacity > BLOCK_INDEX_MIN_CAPACITY ? capacity : BLOCK_INDEX_MIN_CAPACITY) != 0) {
+        fprintf(stderr, "Error: Unable to map block index '%s'.\n", index_path);
+        free(index_path);
+        block_file_close(file);
+        return -1;
+    }
+    free(index_path);
+    BlockIndex* index = file->index;
+    if (memcmp(index->magic, BLOCK_INDEX_MAGIC, sizeof(index->magic)) != 0 || index->version != BLOCK_FILE_VERSION ||
+        index->count > capacity) {
+        memset(index, 0, sizeof(BlockIndex));
+        memcpy(index->magic, BLOCK_INDEX_MAGIC, sizeof(index->magic));
+        index->version = BLOCK_FILE_VERSION;
+    }
+
+    // Check every record, keeping the index entries that agree with the file
+    // and rebuilding the rest. Only a record cut short at the very end (a
+    // crash mid-append) is dropped; any other damage leaves the file untouched.
+    size_t indexed = index->count;
+    uint64_t position = sizeof(BlockFileHeader);
+    index->count = 0;
+    while (position < file->map_size) {
+        const BlockRecord* record = (const BlockRecord*)((const char*)file->map + position);
+        const char* damage = check_record(record, file->map_size - position, file->index->count);
+        if (damage != NULL && read_only) {
+            file->damage = damage;
+            break;
+        }
+        if (damage == record_torn) {
+            break;
+        }
+        if (damage != NULL) {
+            fprintf(stderr, "Error: Block %llu in '%s' is damaged (%s); the file was left as is.\n",
+                    (unsigned long long)file->index->count, path, damage);
+            block_file_close(file);
+            return -1;
+        }
+        if (file->index->count < indexed && file->index->offsets[file->index->count] == position) {
+            file->index->count++;
+        } else {
+            indexed = 0; // Entries from here on are rewritten
+            if (index_block(file, position) != 0) {
+                fprintf(stderr, "Error: Unable to grow block index for '%s'.\n", path);
+                block_file_close(file);
+                return -1;
+            }
+        }
+        position += record->length;
+    }
+    if (position != file->map_size && !read_only && ftruncate(file->fd, (off_t)position) != 0) {
+        fprintf(stderr, "Error: Unable to drop the torn record at the end of block file '%s'.\n", path);
+        block_file_close(file);
+        return -1;
+    }
+    file->size = position;
+    return 0;
+}
+
+// Function to get the number of blocks in the file
+size_t block_file_count(const BlockFile* file) {
+    return (size_t)file->index->count;
+}
+
+// Function to get the record of block index, if it was in the file at open (NULL otherwise)
+// O(1) through the offset index.
+const BlockRecord* block_file_record(const BlockFile* file, size_t index) {
+    if (index >= file->index->count || file->index->offsets[index] >= file->map_size) {
+        return NULL; // Appended since the file was opened
+    }
+    return (const BlockRecord*)((const char*)file->map + file->index->offsets[index]);
+}
+
+// Function to step through a block record's transactions
+// *offset starts at sizeof(BlockRecord) and is advanced past the transaction.
+// Returns NULL if the transaction would run past the end of the record.
+const Transaction* block_record_transaction(const BlockRecord* record, size_t* offset) {
+    if (*offset + sizeof(Transaction) >= record->length) {
+        return NULL;
+    }
+    const Transaction* transaction = (const Transaction*)((const char*)record + *offset);
+    uint64_t size = sizeof(Transaction) + (uint64_t)transaction->details_length + 1;
+    if (size > record->length - *offset || transaction->details[transaction->details_length] != '\0') {
+        return NULL;
+    }
+    *offset += padded(size);
+    return transaction;
+}
+
+// Function to append a mined block to the file and index it
+// The record is written with one write and fsync'd before it is indexed, so
+// the index never points past what is on disk. After a failed write the file
+// refuses every later block, so it always holds a gapless prefix of the chain.
+// Returns 0 on success, -1 on error.
+int block_file_append(BlockFile* file, const Block* block) {
+    if (file->failed) {
+        return -1;
+    }
+    uint64_t length = sizeof(BlockRecord);
+    for (int i = 0; i < block->transaction_count; i++) {
+        length += padded(sizeof(Transaction) + block->transactions[i]->details_length + 1);
+    }
+    BlockRecord* record = (BlockRecord*)calloc(1, length);
+    if (!record) {
+        fprintf(stderr, "Error: Memory allocation failed for block record.\n");
+        exit(1);
+    }
+    record->length = length;
+    record->index = block->index;
+    record->nonce = block->nonce;
+    record->creation_time = (int64_t)block->creation_time;
+    record->transaction_count = (uint32_t)block->transaction_count;
+    record->target = block->target;
+    memcpy(record->previous_block_hash, block->previous_block_hash, SHA256_DIGEST_LENGTH);
+    memcpy(record->block_hash, block->block_hash, SHA256_DIGEST_LENGTH);
+    memcpy(record->transactions_root, block->transactions_root, SHA256_DIGEST_LENGTH);
+    size_t offset = sizeof(BlockRecord);
+    for (int i = 0; i < block->transaction_count; i++) {
+        const Transaction* transaction = block->transactions[i];
+        size_t size = sizeof(Transaction) + transaction->details_length + 1;
+        memcpy((char*)record + offset, transaction, size);
+        offset += padded(size);
+    }
+
+    int failed = write_fully(file->fd, record, length) != 0 || fsync(file->fd) != 0;
+    free(record);
+    if (failed) {
+        fprintf(stderr, "Error: Unable to write block %d to the block file; it and every later block "
+                        "will be kept in memory only.\n", block->index);
+        if (ftruncate(file->fd, (off_t)file->size) != 0) {
+            fprintf(stderr, "Error: Unable to drop the partial block record.\n");
+        }
+        file->failed = 1;
+        return -1;
+    }
+    if (!file->index_stale && index_block(file, file->size) != 0) {
+        // Later offsets would land in the wrong slots; the next open rebuilds them
+        fprintf(stderr, "Error: Unable to grow the block index; it will be rebuilt on the next open.\n");
+        file->index_stale = 1;
+    }
+    file->size += length;
+    return 0;
+}
+
+// Function to close a block file (free the blockchain first: loaded transactions live in the mapping)
+void block_file_close(BlockFile* file) {
+    if (file->map != NULL) {
+        munmap(file->map, file->map_size);
+        file->map = NULL;
+    }
+    if (file->index != NULL) {
+        msync(file->index, sizeof(BlockIndex) + file->index_capacity * sizeof(uint64_t), MS_SYNC);
+        munmap(file->index, sizeof(BlockIndex) + file->index_capacity * sizeof(uint64_t));
+        file->index = NULL;
+    }
+    if (file->index_fd >= 0) {
+        close(file->index_fd);
+        file->index_fd = -1;
+    }
+    if (file->fd >= 0) {
+        close(file->fd);
+        file->fd = -1;
+    }
+}
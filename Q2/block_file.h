@@ -0,0 +1,71 @@
+#ifndef BLOCK_FILE_H
+#define BLOCK_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "block.h"
+
+#define BLOCK_FILE_MAGIC "SCBLOCKS"
+#define BLOCK_INDEX_MAGIC "SCBINDEX"
+#define BLOCK_FILE_VERSION 2 // 2: headers commit the proof-of-work target
+#define BLOCK_FILE_ALIGNMENT 8 // Records and the transactions inside them start at multiples of this
+#define BLOCK_INDEX_MIN_CAPACITY 1024 // Offsets the index file has room for when created
+
+// Block file header, written once when the file is created
+typedef struct {
+    char magic[8]; // BLOCK_FILE_MAGIC
+    uint32_t version; // BLOCK_FILE_VERSION
+    uint32_t record_size; // sizeof(BlockRecord), guards against layout changes
+    uint32_t transaction_size; // sizeof(Transaction), likewise
+    char reserved[44]; // Pads the header to 64 bytes
+} BlockFileHeader;
+
+// Fixed part of one mined block in the block file
+// It is followed by transaction_count Transaction records in their in-memory
+// layout (details and NUL inline), each padded to BLOCK_FILE_ALIGNMENT, so
+// loaded blocks use their transactions in place from the mapping.
+typedef struct {
+    uint64_t length; // Bytes in the record, transactions and padding included
+    int32_t index; // Block index
+    uint32_t nonce;
+    int64_t creation_time;
+    uint32_t transaction_count;
+    uint32_t target; // Compact proof-of-work target
+    unsigned char previous_block_hash[SHA256_DIGEST_LENGTH];
+    unsigned char block_hash[SHA256_DIGEST_LENGTH];
+    unsigned char transactions_root[SHA256_DIGEST_LENGTH];
+} BlockRecord;
+
+// Header of the index file; offsets[i] is where block i's record starts in the block file
+typedef struct {
+    char magic[8]; // BLOCK_INDEX_MAGIC
+    uint32_t version; // BLOCK_FILE_VERSION
+    uint32_t reserved;
+    uint64_t count; // Blocks indexed
+    char padding[40]; // Pads the header to 64 bytes
+    uint64_t offsets[];
+} BlockIndex;
+
+// An open block file and its offset index
+typedef struct {
+    int fd; // Block file, opened for appending
+    uint64_t size; // Bytes of complete records in the block file
+    void* map; // Read-only view of the blocks present at open
+    size_t map_size; // Bytes mapped
+    int index_fd; // Index file (<path>.index)
+    BlockIndex* index; // Writable mapping of the index file
+    size_t index_capacity; // Offsets the mapping has room for
+    int index_stale; // Growing the index failed: stop adding to it until the next open
+    int failed; // A write failed (or the file is read-only): no later block is appended, so the file has no gaps
+    const char* damage; // Read-only opens: what is wrong with the record after the last block loaded, or NULL
+} BlockFile;
+
+// Function prototypes
+int block_file_open(BlockFile* file, const char* path, int read_only);
+size_t block_file_count(const BlockFile* file);
+const BlockRecord* block_file_record(const BlockFile* file, size_t index);
+const Transaction* block_record_transaction(const BlockRecord* record, size_t* offset);
+int block_file_append(BlockFile* file, const Block* block);
+void block_file_close(BlockFile* file);
+
+#endif
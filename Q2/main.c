@@ -1,126 +1,1078 @@
+// SHA-256 midstates need the low-level SHA256_CTX API, deprecated in OpenSSL 3.0
+#define OPENSSL_SUPPRESS_DEPRECATED
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <time.h>
 #include <openssl/sha.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <signal.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "metrics.h"
+#include "sha256_lanes.h"
+#include "arena.h"
+#include "mempool.h"
+#include "block.h"
+#include "block_file.h"
+#include "provenance.h"
 
-#define MAX_TRANSACTIONS_PER_BLOCK 10
-#define LEADING_ZEROS 4 // Difficulty level: number of leading zeros in hash
+#define DEFAULT_BLOCK_TRANSACTIONS 10000 // Default cap on transactions per block
+#define DEFAULT_BLOCK_BYTES (4 * 1024 * 1024) // Default cap on transaction bytes per block
+#define MERKLE_MAX_HEIGHT 32 // Enough peaks for any int transaction count
+#define DEFAULT_DIFFICULTY_BITS 16 // Leading zero bits a block hash needs by default (four hex zeros)
+#define BLOCK_HEADER_LENGTH 88 // Serialized header: previous hash, transactions digest, index, time, count, target, nonce
+#define HEADER_PREFIX_LENGTH 64 // The two hashes fill exactly one SHA-256 block, hashed once per mined block
+#define HEADER_TAIL_WORDS ((BLOCK_HEADER_LENGTH - HEADER_PREFIX_LENGTH) / 4) // Header words in the final SHA-256 block
+#define NONCE_WORD (HEADER_TAIL_WORDS - 1) // The nonce is the header's last word
+#define BENCHMARK_DIFFICULTIES {12, 16, 20} // Leading zero bits benchmarked when no difficulty is given
+#define MAX_MINING_THREADS 64
+#define DEFAULT_MEMPOOL_CAPACITY 65536 // Transactions that can wait to be mined
+#define AUTO_MINE_POLL_MS 50 // How often an idle auto-miner checks the mempool
+#define MINER_BATCH 4096 // Transactions the miner takes from the mempool and signs at a time
+#define MIN_SIGNING_SLICE 512 // Fewest transactions worth a signing thread of their own
+#define MIN_VALIDATION_BLOCKS 16 // Fewest blocks worth a validation thread of their own
 
-// Structure to represent a transaction
+// Operations timed by the metrics layer (see metrics.h)
+typedef enum {
+    METRIC_MINE_BLOCK,
+    METRIC_APPEND_TRANSACTION,
+    METRIC_SUBMIT_TRANSACTION,
+    METRIC_APPEND_BATCH,
+    METRIC_VALIDATE_CHAIN,
+    METRIC_COUNT
+} ChainMetric;
+
+// Names of the operations in metrics dumps, by ChainMetric
+static const char* const metric_names[METRIC_COUNT] = {"mine_new_block", "append_transaction", "submit_transaction",
+                                                           "append_transactions", "validate_blockchain"};
+
+// One transaction of a batch passed to append_transactions
 typedef struct {
-    int id; // Unique identifier for the transaction
-    char details[256]; // Description of the transaction
-    char hash_signature[65]; // SHA-256 signature as a hex string
-} Transaction;
-
-// Structure to represent a block in the blockchain
-typedef struct Block {
-    int index; // Position of the block in the blockchain
-    time_t creation_time; // Timestamp of when the block was created
-    Transaction transactions[MAX_TRANSACTIONS_PER_BLOCK]; // Array of transactions
-    int transaction_count; // Current number of transactions in the block
-    char previous_block_hash[65]; // Hash of the previous block
-    char block_hash[65]; // Hash of the current block
-    int nonce; // Random value used for mining
-    struct Block* next; // Pointer to the next block in the chain
-} Block;
+    int id; // Item ID
+    const char* details; // Description, copied into the chain
+} TransactionInput;
+
 
 // Structure for the blockchain
+// Once the background miner runs, it alone assembles pending_block, allocates
+// from the arena and writes head. Readers see a new block only when it is fully
+// mined: it is published with one release store of head, and published blocks
+// never change, so display_blockchain walks them without locking.
 typedef struct {
-    Block* head; // Pointer to the first block in the chain
+    _Atomic(Block*) head; // Pointer to the newest block in the chain
     Block* pending_block; // Temporary block for pending transactions
     bool initialized; // Initialization status
+    int mining_threads; // Worker threads used to mine each block
+    Sha256Kernel hash_kernel; // SHA-256 kernel the miners use
+    int max_block_transactions; // Transactions a block may hold (0 = no limit)
+    size_t max_block_bytes; // Transaction bytes a block may hold (0 = no limit)
+    uint32_t target; // Compact proof-of-work target for new blocks (0 = DEFAULT_DIFFICULTY_BITS)
+    Arena arena; // Blocks, transactions and their details; freed with the chain
+    unsigned char pending_peaks[MERKLE_MAX_HEIGHT][SHA256_DIGEST_LENGTH]; // Merkle tree of the pending block's transactions
+    atomic_size_t memory_reserved; // Arena bytes reserved as of the last published block
+    atomic_size_t memory_used; // Arena bytes used as of the last published block
+    Mempool mempool; // Transactions submitted but not yet in a block
+    atomic_int miner_held; // Transactions the miner took from the mempool that did not fit in the last block
+    size_t mempool_capacity; // Mempool size requested on the command line
+    bool auto_mine; // Mine whenever the mempool is not empty instead of on request
+    bool miner_running; // Background miner thread started
+    pthread_t miner; // Background miner thread
+    pthread_mutex_t miner_lock; // Guards mine_requests and stopping
+    pthread_cond_t miner_wake; // Signalled on a mining request or shutdown
+    int mine_requests; // Blocks requested and not yet started
+    bool stopping; // Set to make the miner exit
+    BlockFile* file; // Where mined blocks are stored (NULL = memory only)
+    pthread_mutex_t index_lock; // Guards blocks and provenance, which the miner extends
+    Block** blocks; // Published blocks by index
+    int block_count; // Entries in use in blocks
+    int block_capacity; // Entries allocated in blocks
+    ProvenanceIndex provenance; // Item ID -> positions of its transactions
 } Blockchain;
 
+// Outcome of mining one block
+typedef struct {
+    unsigned long long attempts; // Hashes computed by all workers
+    double seconds; // Wall-clock time spent
+    int threads; // Workers that took part
+    Sha256Kernel kernel; // SHA-256 kernel they ran
+} MiningStats;
+
+// State shared by the workers mining one block
+typedef struct {
+    const Block* block; // Block being mined (read-only while workers run)
+    Sha256Kernel kernel; // Resolved kernel, never AUTO
+    unsigned char target[SHA256_DIGEST_LENGTH]; // Block's target, expanded to 256 bits
+    int stride; // Number of workers: worker t tries nonces t+1, t+1+stride, ...
+    atomic_bool found; // Set by the first worker to find a solution; the rest stop
+    uint32_t nonce; // Winning nonce (written by the winner only)
+    unsigned char hash[SHA256_DIGEST_LENGTH]; // Winning hash
+} MiningJob;
+
+// One mining worker's slice of the nonce space
+typedef struct {
+    MiningJob* job;
+    int first_nonce;
+    unsigned long long attempts;
+} MiningWorker;
+
+// Outcome of validate_blockchain
+typedef struct {
+    bool valid; // Every block checked out
+    int first_invalid; // Lowest invalid block index, or -1
+    const char* reason; // Why that block failed
+    int blocks; // Blocks in the chain
+    int threads; // Workers that checked blocks
+    double seconds; // Wall-clock time spent
+} ValidationResult;
+
+// A contiguous range of block indexes checked by one validation worker
+typedef struct {
+    Block* const* blocks; // The chain's index -> block table
+    int begin; // First index to check
+    int end; // One past the last index to check
+    const unsigned char* minimum; // Easiest target a block may commit to (the chain's target)
+    int first_invalid; // Lowest invalid index found, or -1
+    const char* reason; // Why it failed
+} ValidationRange;
+
+// Slice of a batch signed by one thread of append_transactions
+typedef struct {
+    Transaction** transactions; // Records to sign, in block order
+    unsigned char (*leaves)[SHA256_DIGEST_LENGTH]; // Merkle leaf hash of each record's signature
+    int count; // Records in the slice
+} SigningWorker;
+
 // Function prototypes
-void generate_hash(Block* block, char* output_hash);
-void mine_new_block(Block* block);
-bool append_transaction(Block* block, int id, const char* details);
+void serialize_header(const Block* block, unsigned char header[BLOCK_HEADER_LENGTH]);
+void generate_hash(const Block* block, unsigned char digest[SHA256_DIGEST_LENGTH]);
+void target_from_compact(uint32_t compact, unsigned char target[SHA256_DIGEST_LENGTH]);
+uint32_t target_to_compact(const unsigned char target[SHA256_DIGEST_LENGTH]);
+uint32_t target_for_bits(int zero_bits);
+double target_difficulty(uint32_t compact);
+bool meets_target(const unsigned char digest[SHA256_DIGEST_LENGTH], const unsigned char target[SHA256_DIGEST_LENGTH]);
+void hash_to_hex(const unsigned char digest[SHA256_DIGEST_LENGTH], char hex[65]);
+void merkle_append(unsigned char peaks[][SHA256_DIGEST_LENGTH], int count, const unsigned char signature[SHA256_DIGEST_LENGTH]);
+void merkle_root(const unsigned char peaks[][SHA256_DIGEST_LENGTH], int count, unsigned char root[SHA256_DIGEST_LENGTH]);
+void compute_transactions_root(const Block* block, unsigned char root[SHA256_DIGEST_LENGTH]);
+void mine_new_block(Block* block, int threads, Sha256Kernel kernel, MiningStats* stats);
+int run_self_test(void);
+int run_benchmark(int blocks, int max_threads, Sha256Kernel kernel, uint32_t target);
+bool append_transaction(Blockchain* blockchain, int id, const char* details);
+int append_transactions(Blockchain* blockchain, const TransactionInput* inputs, int count);
 void initialize_blockchain(Blockchain* blockchain);
-void insert_block(Blockchain* blockchain, Block* new_block);
+Block* new_pending_block(Blockchain* blockchain);
+void free_blockchain(Blockchain* blockchain);
+bool submit_transaction(Blockchain* blockchain, int id, const char* details);
+size_t pending_transactions(Blockchain* blockchain);
+void start_miner(Blockchain* blockchain);
+bool request_mining(Blockchain* blockchain);
+void stop_miner(Blockchain* blockchain);
+void insert_block(Blockchain* blockchain, Block* new_block, MiningStats* stats);
+bool validate_blockchain(Blockchain* blockchain, int threads, ValidationResult* result);
 void display_blockchain(const Blockchain* blockchain);
+void display_item_history(Blockchain* blockchain, int id);
 void clear_input_buffer();
 int show_menu(bool initialized, bool has_pending);
 
+// Store an integer in little-endian byte order
+static void put_little_endian(unsigned char* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+// Lay out the block header that proof of work hashes
+// Bytes 0-63 never change while a block is mined, and the nonce is the last
+// field, so miners hash the prefix once and only the 24-byte tail per attempt.
+void serialize_header(const Block* block, unsigned char header[BLOCK_HEADER_LENGTH]) {
+    memcpy(header, block->previous_block_hash, SHA256_DIGEST_LENGTH);
+    memcpy(header + 32, block->transactions_root, SHA256_DIGEST_LENGTH);
+    put_little_endian(header + 64, (uint32_t)block->index, 4);
+    put_little_endian(header + 68, (uint64_t)block->creation_time, 8);
+    put_little_endian(header + 76, (uint32_t)block->transaction_count, 4);
+    put_little_endian(header + 80, block->target, 4);
+    put_little_endian(header + 84, block->nonce, 4);
+}
+
 // Generate SHA-256 hash for the block
-void generate_hash(Block* block, char* output_hash) {
-    char buffer[1024];
-    snprintf(buffer, sizeof(buffer), "%d%ld%d%s%d", 
-             block->index, block->creation_time, block->transaction_count, 
-             block->previous_block_hash, block->nonce);
+void generate_hash(const Block* block, unsigned char digest[SHA256_DIGEST_LENGTH]) {
+    unsigned char header[BLOCK_HEADER_LENGTH];
+    serialize_header(block, header);
+    SHA256(header, BLOCK_HEADER_LENGTH, digest);
+}
 
-    unsigned char hash_bytes[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)buffer, strlen(buffer), hash_bytes);
+// Expand a compact target into a 256-bit big-endian number
+// The compact form is the one Bitcoin headers use: the top byte is the
+// target's length in bytes, the low 24 bits its three most significant bytes.
+void target_from_compact(uint32_t compact, unsigned char target[SHA256_DIGEST_LENGTH]) {
+    int size = (int)(compact >> 24);
+    uint32_t mantissa = compact & 0x007fffffu;
 
+    memset(target, 0, SHA256_DIGEST_LENGTH);
+    if (size < 3) {
+        mantissa >>= 8 * (3 - size);
+        size = 3;
+    }
+    for (int i = 0; i < 3; i++) {
+        int position = size - 3 + i; // Byte position counted from the least significant end
+        if (position < SHA256_DIGEST_LENGTH) {
+            target[SHA256_DIGEST_LENGTH - 1 - position] = (unsigned char)(mantissa >> (8 * i));
+        }
+    }
+}
+
+// Encode a 256-bit target compactly, rounding it down to three significant bytes
+uint32_t target_to_compact(const unsigned char target[SHA256_DIGEST_LENGTH]) {
+    int first = 0;
+    while (first < SHA256_DIGEST_LENGTH && target[first] == 0) {
+        first++;
+    }
+    if (first == SHA256_DIGEST_LENGTH) {
+        return 0;
+    }
+    uint32_t size = (uint32_t)(SHA256_DIGEST_LENGTH - first);
+    uint32_t mantissa = 0;
+    for (int i = 0; i < 3; i++) {
+        mantissa = (mantissa << 8) | (first + i < SHA256_DIGEST_LENGTH ? target[first + i] : 0);
+    }
+    if (mantissa & 0x00800000u) {
+        mantissa >>= 8; // The top mantissa bit is a sign bit in this encoding
+        size++;
+    }
+    return (size << 24) | mantissa;
+}
+
+// Compact target met by hashes with at least zero_bits (1-255) leading zero bits
+uint32_t target_for_bits(int zero_bits) {
+    unsigned char target[SHA256_DIGEST_LENGTH] = {0};
+    int bit = 256 - zero_bits; // Hashes must be below 2^bit
+    target[SHA256_DIGEST_LENGTH - 1 - bit / 8] = (unsigned char)(1u << (bit % 8));
+    return target_to_compact(target);
+}
+
+// Express a compact target as the number of leading zero bits it is equivalent to
+// Each extra bit doubles the expected hashes per block.
+double target_difficulty(uint32_t compact) {
+    uint32_t mantissa = compact & 0x007fffffu;
+    if (mantissa == 0) {
+        return 256.0;
+    }
+    return 256.0 - (log2((double)mantissa) + 8.0 * ((int)(compact >> 24) - 3));
+}
+
+// Check that a hash, read as a 256-bit big-endian number, is below a target
+bool meets_target(const unsigned char digest[SHA256_DIGEST_LENGTH], const unsigned char target[SHA256_DIGEST_LENGTH]) {
+    return memcmp(digest, target, SHA256_DIGEST_LENGTH) < 0;
+}
+
+// Hex-encode a raw hash for display
+void hash_to_hex(const unsigned char digest[SHA256_DIGEST_LENGTH], char hex[65]) {
+    static const char digits[] = "0123456789abcdef";
     for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(&output_hash[i * 2], "%02x", hash_bytes[i]);
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0x0f];
     }
+    hex[SHA256_DIGEST_LENGTH * 2] = '\0';
 }
 
-// Mine a block by finding a nonce that results in a hash with specified leading zeros
-void mine_new_block(Block* block) {
-    char hash_output[65];
-    do {
-        block->nonce++;
-        generate_hash(block, hash_output);
-    } while (strncmp(hash_output, "0000", LEADING_ZEROS) != 0);
+// Hash a Merkle tree node from its children (RFC 6962: 0x01 || left || right)
+static void merkle_node(const unsigned char left[SHA256_DIGEST_LENGTH], const unsigned char right[SHA256_DIGEST_LENGTH],
+                        unsigned char out[SHA256_DIGEST_LENGTH]) {
+    static const unsigned char node_prefix = 0x01;
+    SHA256_CTX context;
+    SHA256_Init(&context);
+    SHA256_Update(&context, &node_prefix, 1);
+    SHA256_Update(&context, left, SHA256_DIGEST_LENGTH);
+    SHA256_Update(&context, right, SHA256_DIGEST_LENGTH);
+    SHA256_Final(out, &context);
+}
 
-    strcpy(block->block_hash, hash_output);
+// Hash a signature into a Merkle leaf
+static void merkle_leaf(const unsigned char signature[SHA256_DIGEST_LENGTH], unsigned char leaf[SHA256_DIGEST_LENGTH]) {
+    static const unsigned char leaf_prefix = 0x00;
+    SHA256_CTX context;
+    SHA256_Init(&context);
+    SHA256_Update(&context, &leaf_prefix, 1);
+    SHA256_Update(&context, signature, SHA256_DIGEST_LENGTH);
+    SHA256_Final(leaf, &context);
 }
 
-// Add a transaction to a block
-bool append_transaction(Block* block, int id, const char* details) {
-    if (block->transaction_count >= MAX_TRANSACTIONS_PER_BLOCK) {
-        return false; // Block is full
+// Add the count-th leaf hash to a Merkle tree kept as its peaks
+static void merkle_push(unsigned char peaks[][SHA256_DIGEST_LENGTH], int count, const unsigned char leaf[SHA256_DIGEST_LENGTH]) {
+    unsigned char carry[SHA256_DIGEST_LENGTH];
+    int height = 0;
+
+    memcpy(carry, leaf, SHA256_DIGEST_LENGTH);
+    for (; (unsigned)count & (1u << height); height++) {
+        merkle_node(peaks[height], carry, carry);
     }
+    memcpy(peaks[height], carry, SHA256_DIGEST_LENGTH);
+}
+
+// Add the count-th signature to a transaction Merkle tree kept as its peaks
+// peaks[k] is the root of a complete subtree of 2^k leaves and is present when
+// bit k of count is set. Appending merges equal-sized subtrees like a binary
+// counter, so it costs one hash per trailing one bit of count (O(1) amortized).
+void merkle_append(unsigned char peaks[][SHA256_DIGEST_LENGTH], int count, const unsigned char signature[SHA256_DIGEST_LENGTH]) {
+    unsigned char leaf[SHA256_DIGEST_LENGTH];
+    merkle_leaf(signature, leaf);
+    merkle_push(peaks, count, leaf);
+}
+
+// Compute the Merkle root of count transactions from their peaks
+// Folding the peaks from the smallest up gives the RFC 6962 root, where the
+// left subtree is always the largest complete one. An empty tree hashes "".
+void merkle_root(const unsigned char peaks[][SHA256_DIGEST_LENGTH], int count, unsigned char root[SHA256_DIGEST_LENGTH]) {
+    bool have_root = false;
+    if (count == 0) {
+        SHA256((const unsigned char*)"", 0, root);
+        return;
+    }
+    for (int height = 0; height < MERKLE_MAX_HEIGHT; height++) {
+        if ((unsigned)count & (1u << height)) {
+            if (have_root) {
+                merkle_node(peaks[height], root, root);
+            } else {
+                memcpy(root, peaks[height], SHA256_DIGEST_LENGTH);
+                have_root = true;
+            }
+        }
+    }
+}
+
+// Recompute a block's transaction root from its stored signatures (for verification)
+void compute_transactions_root(const Block* block, unsigned char root[SHA256_DIGEST_LENGTH]) {
+    unsigned char peaks[MERKLE_MAX_HEIGHT][SHA256_DIGEST_LENGTH];
+    for (int i = 0; i < block->transaction_count; i++) {
+        merkle_append(peaks, i, block->transactions[i]->hash_signature);
+    }
+    merkle_root(peaks, block->transaction_count, root);
+}
+
+// Read a big-endian 32-bit word
+static uint32_t get_big_endian(const unsigned char* in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+// Hash the constant header prefix once; every attempt resumes from this midstate
+static void header_midstate(const unsigned char header[BLOCK_HEADER_LENGTH], uint32_t state[8]) {
+    SHA256_CTX prefix;
+    SHA256_Init(&prefix);
+    SHA256_Update(&prefix, header, HEADER_PREFIX_LENGTH);
+    for (int i = 0; i < 8; i++) {
+        state[i] = prefix.h[i];
+    }
+}
+
+// Lay out the header's final SHA-256 block in every lane: the 20-byte tail,
+// the 0x80 padding byte and the message length in bits. Word 4 is the nonce.
+static void header_tail_words(const unsigned char header[BLOCK_HEADER_LENGTH], uint32_t words[16][SHA256_MAX_LANES]) {
+    for (int i = 0; i < 16; i++) {
+        uint32_t word = 0;
+        if (i < HEADER_TAIL_WORDS) {
+            word = get_big_endian(header + HEADER_PREFIX_LENGTH + 4 * i);
+        } else if (i == HEADER_TAIL_WORDS) {
+            word = 0x80000000u;
+        } else if (i == 15) {
+            word = BLOCK_HEADER_LENGTH * 8;
+        }
+        for (int lane = 0; lane < SHA256_MAX_LANES; lane++) {
+            words[i][lane] = word;
+        }
+    }
+}
+
+// Write a lane's digest words out as the 32-byte hash
+static void lane_digest(const uint32_t digest[8][SHA256_MAX_LANES], int lane, unsigned char out[SHA256_DIGEST_LENGTH]) {
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (unsigned char)(digest[i][lane] >> 24);
+        out[i * 4 + 1] = (unsigned char)(digest[i][lane] >> 16);
+        out[i * 4 + 2] = (unsigned char)(digest[i][lane] >> 8);
+        out[i * 4 + 3] = (unsigned char)digest[i][lane];
+    }
+}
+
+// Resolve a requested worker thread count (0 = one per online CPU)
+static int worker_threads(int requested) {
+    int threads = requested > 0 ? requested : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) {
+        return 1;
+    }
+    return threads > MAX_MINING_THREADS ? MAX_MINING_THREADS : threads;
+}
+
+// Search one worker's nonces until a solution turns up anywhere or they run out
+// Each call to the kernel tries SHA256_MAX_LANES of the worker's nonces at once.
+static void* mine_nonces(void* arg) {
+    MiningWorker* worker = (MiningWorker*)arg;
+    MiningJob* job = worker->job;
+    unsigned char header[BLOCK_HEADER_LENGTH];
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    uint32_t state[8];
+    uint32_t words[16][SHA256_MAX_LANES] __attribute__((aligned(32)));
+    uint32_t digest[8][SHA256_MAX_LANES] __attribute__((aligned(32)));
+    uint64_t stride = (uint64_t)job->stride;
+    // Hashes whose first word is above the target's are rejected without building the digest
+    uint32_t first_word_limit = get_big_endian(job->target);
+
+    serialize_header(job->block, header);
+    header_midstate(header, state);
+    header_tail_words(header, words);
+
+    for (uint64_t base = (uint64_t)worker->first_nonce; base <= UINT32_MAX; base += stride * SHA256_MAX_LANES) {
+        if (atomic_load_explicit(&job->found, memory_order_relaxed)) {
+            break; // Another worker won
+        }
+        for (int lane = 0; lane < SHA256_MAX_LANES; lane++) {
+            words[NONCE_WORD][lane] = __builtin_bswap32((uint32_t)(base + lane * stride)); // Nonce is little-endian in the header
+        }
+        sha256_compress_lanes(job->kernel, state, words, digest);
+
+        for (int lane = 0; lane < SHA256_MAX_LANES; lane++) {
+            uint64_t nonce = base + lane * stride;
+            if (nonce > UINT32_MAX) {
+                break; // Past the end of the nonce space
+            }
+            worker->attempts++;
+            if (digest[0][lane] > first_word_limit) {
+                continue;
+            }
+            lane_digest(digest, lane, hash);
+            if (meets_target(hash, job->target)) {
+                bool expected = false;
+                if (atomic_compare_exchange_strong(&job->found, &expected, true)) {
+                    job->nonce = (uint32_t)nonce;
+                    memcpy(job->hash, hash, SHA256_DIGEST_LENGTH);
+                }
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Mine a block by finding a nonce whose hash is below the block's target
+// The nonce space is interleaved across threads workers (0 = one per online CPU);
+// the first to find a solution cancels the others. Workers hash with kernel
+// (AUTO = the widest the CPU supports). stats may be NULL.
+void mine_new_block(Block* block, int threads, Sha256Kernel kernel, MiningStats* stats) {
+    MiningJob job;
+    MiningWorker workers[MAX_MINING_THREADS];
+    pthread_t handles[MAX_MINING_THREADS];
+    struct timespec start, end;
+    unsigned long long attempts = 0;
+    METRIC_START(timer);
+
+    threads = worker_threads(threads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-    Transaction* transaction = &block->transactions[block->transaction_count++];
+    job.block = block;
+    job.kernel = sha256_select_kernel(kernel);
+    target_from_compact(block->target, job.target);
+    job.stride = threads;
+    atomic_init(&job.found, false);
+    while (true) {
+        for (int t = 0; t < threads; t++) {
+            workers[t].job = &job;
+            workers[t].first_nonce = t + 1;
+            workers[t].attempts = 0;
+        }
+        // The calling thread mines the first slice itself
+        int started = 1;
+        for (int t = 1; t < threads; t++, started++) {
+            if (pthread_create(&handles[t], NULL, mine_nonces, &workers[t]) != 0) {
+                break;
+            }
+        }
+        mine_nonces(&workers[0]);
+        for (int t = started; t < threads; t++) {
+            mine_nonces(&workers[t]); // Thread creation failed: finish serially
+        }
+        for (int t = 1; t < started; t++) {
+            pthread_join(handles[t], NULL);
+        }
+        for (int t = 0; t < threads; t++) {
+            attempts += workers[t].attempts;
+        }
+        if (atomic_load(&job.found)) {
+            break;
+        }
+        block->creation_time++; // Every nonce failed: change the header and search again
+    }
+
+    block->nonce = job.nonce;
+    memcpy(block->block_hash, job.hash, SHA256_DIGEST_LENGTH);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (stats != NULL) {
+        stats->attempts = attempts;
+        stats->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        stats->threads = threads;
+        stats->kernel = job.kernel;
+    }
+    METRIC_STOP(METRIC_MINE_BLOCK, timer);
+}
+
+// Copy a transaction into the pending block's next slot, unsigned
+// Returns NULL if it would take the block past its transaction or byte limit.
+static Transaction* reserve_transaction(Blockchain* blockchain, int id, const char* details) {
+    Block* block = blockchain->pending_block;
+    size_t details_length = strlen(details);
+    size_t size = sizeof(Transaction) + details_length + 1;
+
+    if ((blockchain->max_block_transactions > 0 && block->transaction_count >= blockchain->max_block_transactions) ||
+        (blockchain->max_block_bytes > 0 && block->transaction_bytes + size > blockchain->max_block_bytes) ||
+        details_length > UINT32_MAX || block->transaction_count == INT_MAX) {
+        return NULL; // Block is full
+    }
+
+    // Grow the transaction vector by doubling; outgrown arrays stay in the arena
+    if (block->transaction_count == block->transaction_capacity) {
+        int capacity = block->transaction_capacity ? block->transaction_capacity * 2 : 8;
+        Transaction** transactions = (Transaction**)arena_alloc(&blockchain->arena, capacity * sizeof(Transaction*));
+        if (block->transaction_count > 0) {
+            memcpy(transactions, block->transactions, block->transaction_count * sizeof(Transaction*));
+        }
+        block->transactions = transactions;
+        block->transaction_capacity = capacity;
+    }
+
+    Transaction* transaction = (Transaction*)arena_alloc(&blockchain->arena, size);
     transaction->id = id;
-    strncpy(transaction->details, details, sizeof(transaction->details) - 1);
-    
-    // Generate a simple signature
-    char signature_input[512];
-    snprintf(signature_input, sizeof(signature_input), "%d%s", id, details);
-    unsigned char signature_bytes[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)signature_input, strlen(signature_input), signature_bytes);
-    
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(&transaction->hash_signature[i * 2], "%02x", signature_bytes[i]);
+    transaction->details_length = (uint32_t)details_length;
+    memcpy(transaction->details, details, details_length + 1);
+    block->transactions[block->transaction_count++] = transaction;
+    block->transaction_bytes += size;
+    return transaction;
+}
+
+// Compute a transaction's simple signature: SHA-256 of the decimal ID followed by the details
+static void transaction_signature(const Transaction* transaction, unsigned char signature[SHA256_DIGEST_LENGTH]) {
+    char id_text[16];
+    SHA256_CTX context;
+    SHA256_Init(&context);
+    SHA256_Update(&context, id_text, (size_t)snprintf(id_text, sizeof(id_text), "%d", transaction->id));
+    SHA256_Update(&context, transaction->details, transaction->details_length);
+    SHA256_Final(signature, &context);
+}
+
+// Generate a transaction's signature
+static void sign_transaction(Transaction* transaction) {
+    transaction_signature(transaction, transaction->hash_signature);
+}
+
+// Sign one slice of a batch and hash each signature into its Merkle leaf
+static void* sign_slice(void* arg) {
+    SigningWorker* worker = (SigningWorker*)arg;
+    for (int i = 0; i < worker->count; i++) {
+        sign_transaction(worker->transactions[i]);
+        merkle_leaf(worker->transactions[i]->hash_signature, worker->leaves[i]);
+    }
+    return NULL;
+}
+
+// Add a transaction to the pending block
+// Returns false if it would take the block past its transaction or byte limit.
+bool append_transaction(Blockchain* blockchain, int id, const char* details) {
+    METRIC_START(start);
+    Transaction* transaction = reserve_transaction(blockchain, id, details);
+    if (transaction == NULL) {
+        return false;
     }
+    sign_transaction(transaction);
+
+    // Fold the signature into the block's Merkle tree; the header only carries the root
+    Block* block = blockchain->pending_block;
+    merkle_append(blockchain->pending_peaks, block->transaction_count - 1, transaction->hash_signature);
+    merkle_root(blockchain->pending_peaks, block->transaction_count, block->transactions_root);
 
+    METRIC_STOP(METRIC_APPEND_TRANSACTION, start);
     return true;
 }
 
+// Add a batch of transactions to the pending block, in order
+// Records are copied into the arena first; then the signatures and Merkle
+// leaves are computed in parallel slices on the chain's worker threads, and
+// the leaves are folded into the tree in order. The result is the same as
+// calling append_transaction on each input. Stops at the first transaction
+// that does not fit. Returns how many were added.
+int append_transactions(Blockchain* blockchain, const TransactionInput* inputs, int count) {
+    Block* block = blockchain->pending_block;
+    int first = block->transaction_count;
+    int added = 0;
+    METRIC_START(start);
+
+    while (added < count && reserve_transaction(blockchain, inputs[added].id, inputs[added].details) != NULL) {
+        added++;
+    }
+    if (added == 0) {
+        return 0;
+    }
+
+    unsigned char (*leaves)[SHA256_DIGEST_LENGTH] = malloc((size_t)added * SHA256_DIGEST_LENGTH);
+    if (!leaves) {
+        fprintf(stderr, "Error: Memory allocation failed for transaction signing.\n");
+        exit(1);
+    }
+    SigningWorker workers[MAX_MINING_THREADS];
+    pthread_t handles[MAX_MINING_THREADS];
+    int threads = worker_threads(blockchain->mining_threads);
+    if (threads > added / MIN_SIGNING_SLICE) {
+        threads = added / MIN_SIGNING_SLICE > 0 ? added / MIN_SIGNING_SLICE : 1;
+    }
+    for (int t = 0, offset = 0; t < threads; t++) {
+        int slice = added / threads + (t < added % threads);
+        workers[t].transactions = block->transactions + first + offset;
+        workers[t].leaves = leaves + offset;
+        workers[t].count = slice;
+        offset += slice;
+    }
+    // The calling thread signs the first slice itself
+    int started = 1;
+    for (int t = 1; t < threads; t++, started++) {
+        if (pthread_create(&handles[t], NULL, sign_slice, &workers[t]) != 0) {
+            break;
+        }
+    }
+    sign_slice(&workers[0]);
+    for (int t = started; t < threads; t++) {
+        sign_slice(&workers[t]); // Thread creation failed: finish serially
+    }
+    for (int t = 1; t < started; t++) {
+        pthread_join(handles[t], NULL);
+    }
+
+    for (int i = 0; i < added; i++) {
+        merkle_push(blockchain->pending_peaks, first + i, leaves[i]);
+    }
+    merkle_root(blockchain->pending_peaks, block->transaction_count, block->transactions_root);
+    free(leaves);
+
+    METRIC_STOP(METRIC_APPEND_BATCH, start);
+    return added;
+}
+
+// Make a published block findable by index and its transactions by item ID
+static void index_published_block(Blockchain* blockchain, Block* block) {
+    pthread_mutex_lock(&blockchain->index_lock);
+    if (blockchain->block_count == blockchain->block_capacity) {
+        int capacity = blockchain->block_capacity ? blockchain->block_capacity * 2 : 64;
+        Block** blocks = (Block**)realloc(blockchain->blocks, capacity * sizeof(Block*));
+        if (!blocks) {
+            fprintf(stderr, "Error: Memory allocation failed for the block index.\n");
+            exit(1);
+        }
+        blockchain->blocks = blocks;
+        blockchain->block_capacity = capacity;
+    }
+    blockchain->blocks[blockchain->block_count++] = block;
+    for (int slot = 0; slot < block->transaction_count; slot++) {
+        provenance_index_add(&blockchain->provenance, block->transactions[slot]->id, block->index, slot);
+    }
+    pthread_mutex_unlock(&blockchain->index_lock);
+}
+
+// Rebuild the chain from the blocks in its file
+// Transactions are used in place from the file's mapping; only the block
+// structures and their transaction arrays go in the arena.
+static void load_blocks(Blockchain* blockchain) {
+    size_t count = block_file_count(blockchain->file);
+    for (size_t i = 0; i < count; i++) {
+        const BlockRecord* record = block_file_record(blockchain->file, i);
+        Block* block = (Block*)arena_alloc(&blockchain->arena, sizeof(Block));
+        memset(block, 0, sizeof(Block));
+        block->index = record->index;
+        block->creation_time = (time_t)record->creation_time;
+        block->nonce = record->nonce;
+        block->target = record->target;
+        memcpy(block->previous_block_hash, record->previous_block_hash, SHA256_DIGEST_LENGTH);
+        memcpy(block->block_hash, record->block_hash, SHA256_DIGEST_LENGTH);
+        memcpy(block->transactions_root, record->transactions_root, SHA256_DIGEST_LENGTH);
+        if (record->transaction_count > 0) {
+            block->transactions =
+                (Transaction**)arena_alloc(&blockchain->arena, record->transaction_count * sizeof(Transaction*));
+        }
+        size_t offset = sizeof(BlockRecord);
+        for (uint32_t slot = 0; slot < record->transaction_count; slot++) {
+            // block_file_open checked every record, so this never runs off the end
+            Transaction* transaction = (Transaction*)block_record_transaction(record, &offset);
+            block->transactions[slot] = transaction;
+            block->transaction_bytes += sizeof(Transaction) + transaction->details_length + 1;
+        }
+        block->transaction_count = (int)record->transaction_count;
+        block->transaction_capacity = block->transaction_count;
+        block->next = atomic_load_explicit(&blockchain->head, memory_order_relaxed);
+        atomic_store_explicit(&blockchain->head, block, memory_order_release);
+        index_published_block(blockchain, block);
+    }
+    atomic_store_explicit(&blockchain->memory_reserved, blockchain->arena.reserved, memory_order_relaxed);
+    atomic_store_explicit(&blockchain->memory_used, blockchain->arena.used, memory_order_relaxed);
+}
+
+// Check everything about a block that does not depend on other blocks
+// minimum is the easiest target the block may commit to, so a block cannot
+// make itself cheap to re-mine. Returns NULL if it is valid, otherwise why it is not.
+static const char* check_block(const Block* block, int index, const unsigned char minimum[SHA256_DIGEST_LENGTH]) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+
+    if (block->index != index) {
+        return "index out of sequence";
+    }
+    for (int i = 0; i < block->transaction_count; i++) {
+        transaction_signature(block->transactions[i], digest);
+        if (memcmp(digest, block->transactions[i]->hash_signature, SHA256_DIGEST_LENGTH) != 0) {
+            return "transaction signature does not match its contents";
+        }
+    }
+    compute_transactions_root(block, digest);
+    if (memcmp(digest, block->transactions_root, SHA256_DIGEST_LENGTH) != 0) {
+        return "transactions root does not match its transactions";
+    }
+    generate_hash(block, digest);
+    if (memcmp(digest, block->block_hash, SHA256_DIGEST_LENGTH) != 0) {
+        return "block hash does not match its header and nonce";
+    }
+    unsigned char target[SHA256_DIGEST_LENGTH];
+    target_from_compact(block->target, target);
+    if (memcmp(target, minimum, SHA256_DIGEST_LENGTH) > 0) {
+        return "block commits to an easier target than the chain requires";
+    }
+    if (!meets_target(digest, target)) {
+        return "block hash does not meet the difficulty target";
+    }
+    return NULL;
+}
+
+// Check every block of a range on its own
+static void* validate_range(void* arg) {
+    ValidationRange* range = (ValidationRange*)arg;
+    for (int i = range->begin; i < range->end; i++) {
+        const char* reason = check_block(range->blocks[i], i, range->minimum);
+        if (reason != NULL) {
+            range->first_invalid = i;
+            range->reason = reason;
+            break; // Later blocks in this range cannot lower the result
+        }
+    }
+    return NULL;
+}
+
+// Function to check every block's proof of work and every link of the chain
+// Blocks are checked independently on threads workers (0 = one per online CPU),
+// each taking a contiguous range of indexes: signatures, transactions root,
+// header hash and difficulty. A linear pass then checks that each block names
+// its predecessor's hash, up to the first invalid block found. A damaged record
+// that stopped a read-only open of the block file counts as the block after
+// the last one loaded. Call it before the miner starts, or with the miner
+// stopped. result may be NULL. Returns true if the whole chain is valid.
+bool validate_blockchain(Blockchain* blockchain, int threads, ValidationResult* result) {
+    static const unsigned char genesis_previous[SHA256_DIGEST_LENGTH] = {0};
+    ValidationRange ranges[MAX_MINING_THREADS];
+    pthread_t handles[MAX_MINING_THREADS];
+    struct timespec start, end;
+    int total = blockchain->block_count;
+    unsigned char minimum[SHA256_DIGEST_LENGTH];
+    METRIC_START(timer);
+    target_from_compact(blockchain->target, minimum);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int workers = worker_threads(threads);
+    if (workers > total / MIN_VALIDATION_BLOCKS) {
+        workers = total / MIN_VALIDATION_BLOCKS > 0 ? total / MIN_VALIDATION_BLOCKS : 1;
+    }
+    for (int t = 0; t < workers; t++) {
+        ranges[t].blocks = blockchain->blocks;
+        ranges[t].begin = (int)((long long)total * t / workers);
+        ranges[t].end = (int)((long long)total * (t + 1) / workers);
+        ranges[t].minimum = minimum;
+        ranges[t].first_invalid = -1;
+        ranges[t].reason = NULL;
+    }
+    // The calling thread takes the first range itself
+    int started = 1;
+    for (int t = 1; t < workers; t++, started++) {
+        if (pthread_create(&handles[t], NULL, validate_range, &ranges[t]) != 0) {
+            break;
+        }
+    }
+    validate_range(&ranges[0]);
+    for (int t = started; t < workers; t++) {
+        validate_range(&ranges[t]); // Thread creation failed: finish serially
+    }
+    for (int t = 1; t < started; t++) {
+        pthread_join(handles[t], NULL);
+    }
+
+    int first_invalid = -1;
+    const char* reason = NULL;
+    for (int t = 0; t < workers && first_invalid < 0; t++) {
+        first_invalid = ranges[t].first_invalid;
+        reason = ranges[t].reason;
+    }
+    int limit = first_invalid >= 0 ? first_invalid : total;
+    for (int i = 0; i < limit; i++) {
+        const unsigned char* expected = i == 0 ? genesis_previous : blockchain->blocks[i - 1]->block_hash;
+        if (memcmp(blockchain->blocks[i]->previous_block_hash, expected, SHA256_DIGEST_LENGTH) != 0) {
+            first_invalid = i;
+            reason = "previous block hash does not match the block before it";
+            break;
+        }
+    }
+    if (first_invalid < 0 && blockchain->file != NULL && blockchain->file->damage != NULL) {
+        // A read-only open stopped loading at a record it could not use
+        first_invalid = (int)block_file_count(blockchain->file);
+        reason = blockchain->file->damage;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (result != NULL) {
+        result->valid = first_invalid < 0;
+        result->first_invalid = first_invalid;
+        result->reason = reason;
+        result->blocks = total;
+        result->threads = workers;
+        result->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    METRIC_STOP(METRIC_VALIDATE_CHAIN, timer);
+    return first_invalid < 0;
+}
+
+// Print the outcome of validate_blockchain
+static void report_validation(const ValidationResult* result) {
+    if (result->valid) {
+        printf("Validated %d blocks in %.3f s on %d threads (%.0f blocks/sec).\n", result->blocks, result->seconds,
+               result->threads, result->seconds > 0 ? result->blocks / result->seconds : 0.0);
+    } else {
+        printf("Block %d is invalid: %s.\n", result->first_invalid, result->reason);
+    }
+}
+
 // Initialize a new blockchain
 void initialize_blockchain(Blockchain* blockchain) {
-    blockchain->head = NULL;
+    atomic_init(&blockchain->head, NULL);
     blockchain->initialized = true;
-
-    // Allocate memory for the pending block
-    blockchain->pending_block = (Block*)malloc(sizeof(Block));
-    if (!blockchain->pending_block) {
-        fprintf(stderr, "Error: Memory allocation failed for pending block.\n");
-        exit(1);
+    arena_init(&blockchain->arena);
+    mempool_init(&blockchain->mempool, blockchain->mempool_capacity > 0 ? blockchain->mempool_capacity
+                                                                        : DEFAULT_MEMPOOL_CAPACITY);
+    atomic_init(&blockchain->miner_held, 0);
+    if (blockchain->target == 0) {
+        blockchain->target = target_for_bits(DEFAULT_DIFFICULTY_BITS);
     }
-    blockchain->pending_block->index = 0;
-    blockchain->pending_block->transaction_count = 0;
-    strcpy(blockchain->pending_block->previous_block_hash, "0"); // Genesis block
+    pthread_mutex_init(&blockchain->index_lock, NULL);
+    blockchain->blocks = NULL;
+    blockchain->block_count = 0;
+    blockchain->block_capacity = 0;
+    provenance_index_init(&blockchain->provenance);
+    if (blockchain->file != NULL) {
+        load_blocks(blockchain);
+    }
+    blockchain->pending_block = new_pending_block(blockchain);
+}
+
+// Start an empty pending block (index 0 and a zero previous hash until it is inserted)
+Block* new_pending_block(Blockchain* blockchain) {
+    Block* block = (Block*)arena_alloc(&blockchain->arena, sizeof(Block));
+    memset(block, 0, sizeof(Block));
+    block->target = blockchain->target;
+    merkle_root(blockchain->pending_peaks, 0, block->transactions_root);
+    blockchain->pending_block = block;
+    return block;
+}
+
+// Free every block and transaction of the blockchain
+void free_blockchain(Blockchain* blockchain) {
+    stop_miner(blockchain);
+    mempool_destroy(&blockchain->mempool);
+    provenance_index_free(&blockchain->provenance);
+    free(blockchain->blocks);
+    blockchain->blocks = NULL;
+    blockchain->block_count = 0;
+    blockchain->block_capacity = 0;
+    pthread_mutex_destroy(&blockchain->index_lock);
+    arena_destroy(&blockchain->arena);
+    atomic_store(&blockchain->head, NULL);
+    blockchain->pending_block = NULL;
+    blockchain->initialized = false;
 }
 
 // Insert a new block into the blockchain
-void insert_block(Blockchain* blockchain, Block* new_block) {
+void insert_block(Blockchain* blockchain, Block* new_block, MiningStats* stats) {
+    Block* head = atomic_load_explicit(&blockchain->head, memory_order_relaxed); // Only this thread writes head
     new_block->creation_time = time(NULL);
-    new_block->next = blockchain->head;
+    new_block->next = head;
     
-    if (blockchain->head != NULL) {
-        strcpy(new_block->previous_block_hash, blockchain->head->block_hash);
-        new_block->index = blockchain->head->index + 1;
+    if (head != NULL) {
+        memcpy(new_block->previous_block_hash, head->block_hash, SHA256_DIGEST_LENGTH);
+        new_block->index = head->index + 1;
     }
 
-    mine_new_block(new_block);
-    blockchain->head = new_block;
+    mine_new_block(new_block, blockchain->mining_threads, blockchain->hash_kernel, stats);
+    if (blockchain->file != NULL) {
+        block_file_append(blockchain->file, new_block); // On failure this and later blocks stay in memory only
+    }
+    atomic_store_explicit(&blockchain->head, new_block, memory_order_release);
+    index_published_block(blockchain, new_block);
+    atomic_store_explicit(&blockchain->memory_reserved, blockchain->arena.reserved, memory_order_relaxed);
+    atomic_store_explicit(&blockchain->memory_used, blockchain->arena.used, memory_order_relaxed);
+}
+
+// Queue a transaction for mining; safe from any thread and never waits for the miner
+// Returns false if the mempool is full or the transaction could never fit in a block.
+bool submit_transaction(Blockchain* blockchain, int id, const char* details) {
+    if (blockchain->max_block_bytes > 0 && sizeof(Transaction) + strlen(details) + 1 > blockchain->max_block_bytes) {
+        return false;
+    }
+    METRIC_START(start);
+    bool queued = mempool_push(&blockchain->mempool, id, details);
+    METRIC_STOP(METRIC_SUBMIT_TRANSACTION, start);
+    return queued;
+}
+
+// Count transactions waiting to be mined: those in the mempool and those the miner holds
+size_t pending_transactions(Blockchain* blockchain) {
+    return mempool_size(&blockchain->mempool) +
+           (size_t)atomic_load_explicit(&blockchain->miner_held, memory_order_relaxed);
+}
+
+// Fill the pending block from the mempool, mine it and start the next one
+// Transactions are taken and signed MINER_BATCH at a time. batch holds
+// *held entries already taken that did not fit in the previous block; their
+// number is published in miner_held so they still count as pending.
+static void mine_from_mempool(Blockchain* blockchain, MempoolEntry* batch, int* held) {
+    Block* block = blockchain->pending_block;
+    TransactionInput inputs[MINER_BATCH];
+    MiningStats stats;
+
+    for (;;) {
+        while (*held < MINER_BATCH && mempool_pop(&blockchain->mempool, &batch[*held])) {
+            (*held)++;
+        }
+        if (*held == 0) {
+            break;
+        }
+        for (int i = 0; i < *held; i++) {
+            inputs[i].id = batch[i].id;
+            inputs[i].details = batch[i].details;
+        }
+        int added = append_transactions(blockchain, inputs, *held);
+        for (int i = 0; i < added; i++) {
+            free(batch[i].details);
+        }
+        memmove(batch, batch + added, (size_t)(*held - added) * sizeof(MempoolEntry));
+        *held -= added;
+        atomic_store_explicit(&blockchain->miner_held, *held, memory_order_relaxed);
+        if (*held > 0) {
+            break; // Block is full: the rest open the next block
+        }
+    }
+    if (block->transaction_count == 0) {
+        return;
+    }
+
+    insert_block(blockchain, block, &stats);
+    printf("\n[miner] Block %d mined with %d transactions.\n", block->index, block->transaction_count);
+    printf("[miner] Tried %llu nonces in %.3f s on %d threads with the %s kernel (%.0f hashes/sec).\n", stats.attempts,
+           stats.seconds, stats.threads, sha256_kernel_name(stats.kernel),
+           stats.seconds > 0 ? stats.attempts / stats.seconds : 0.0);
+    fflush(stdout);
+    new_pending_block(blockchain);
+}
+
+// Background miner: turn mempool transactions into blocks on request (or continuously with auto_mine)
+static void* miner_loop(void* arg) {
+    Blockchain* blockchain = (Blockchain*)arg;
+    MempoolEntry* batch = (MempoolEntry*)malloc(MINER_BATCH * sizeof(MempoolEntry));
+    int held = 0;
+
+    if (!batch) {
+        fprintf(stderr, "Error: Memory allocation failed for the miner.\n");
+        exit(1);
+    }
+
+    pthread_mutex_lock(&blockchain->miner_lock);
+    for (;;) {
+        if (blockchain->stopping && blockchain->mine_requests == 0) {
+            break; // Requested blocks are finished before stopping
+        }
+        bool work = blockchain->mine_requests > 0 ||
+                    (blockchain->auto_mine && pending_transactions(blockchain) > 0);
+        if (!work) {
+            if (blockchain->auto_mine) {
+                // Producers never lock, so poll for their transactions
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_nsec += AUTO_MINE_POLL_MS * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+                pthread_cond_timedwait(&blockchain->miner_wake, &blockchain->miner_lock, &deadline);
+            } else {
+                pthread_cond_wait(&blockchain->miner_wake, &blockchain->miner_lock);
+            }
+            continue;
+        }
+        if (blockchain->mine_requests > 0) {
+            blockchain->mine_requests--;
+        }
+        pthread_mutex_unlock(&blockchain->miner_lock);
+        mine_from_mempool(blockchain, batch, &held);
+        pthread_mutex_lock(&blockchain->miner_lock);
+    }
+    pthread_mutex_unlock(&blockchain->miner_lock);
+    for (int i = 0; i < held; i++) {
+        free(batch[i].details);
+    }
+    free(batch);
+    return NULL;
+}
+
+// Start the background miner; from now on it owns the pending block and the arena
+void start_miner(Blockchain* blockchain) {
+    pthread_mutex_init(&blockchain->miner_lock, NULL);
+    pthread_cond_init(&blockchain->miner_wake, NULL);
+    blockchain->mine_requests = 0;
+    blockchain->stopping = false;
+    if (pthread_create(&blockchain->miner, NULL, miner_loop, blockchain) != 0) {
+        fprintf(stderr, "Error: Unable to start the miner thread.\n");
+        exit(1);
+    }
+    blockchain->miner_running = true;
+}
+
+// Ask the background miner for a block of the transactions queued so far
+// Returns false (and asks for nothing) if no transaction is waiting.
+bool request_mining(Blockchain* blockchain) {
+    if (pending_transactions(blockchain) == 0) {
+        return false;
+    }
+    pthread_mutex_lock(&blockchain->miner_lock);
+    blockchain->mine_requests++;
+    pthread_cond_signal(&blockchain->miner_wake);
+    pthread_mutex_unlock(&blockchain->miner_lock);
+    return true;
+}
+
+// Stop the background miner once it finishes the blocks already requested
+void stop_miner(Blockchain* blockchain) {
+    if (!blockchain->miner_running) {
+        return;
+    }
+    pthread_mutex_lock(&blockchain->miner_lock);
+    blockchain->stopping = true;
+    pthread_cond_signal(&blockchain->miner_wake);
+    pthread_mutex_unlock(&blockchain->miner_lock);
+    pthread_join(blockchain->miner, NULL);
+    pthread_mutex_destroy(&blockchain->miner_lock);
+    pthread_cond_destroy(&blockchain->miner_wake);
+    blockchain->miner_running = false;
 }
 
 // Display the entire blockchain
@@ -130,26 +1082,56 @@ void display_blockchain(const Blockchain* blockchain) {
         return;
     }
 
-    if (blockchain->head == NULL) {
+    Block* current = atomic_load_explicit(&blockchain->head, memory_order_acquire);
+    if (current == NULL) {
         printf("Blockchain is empty. No blocks mined yet.\n");
         return;
     }
 
-    Block* current = blockchain->head;
+    char hex[65];
     while (current != NULL) {
         printf("Block %d\n", current->index);
         printf("Creation Time: %ld\n", current->creation_time);
         printf("Transactions:\n");
         for (int i = 0; i < current->transaction_count; i++) {
             printf("  Item ID: %d, Details: %s\n", 
-                   current->transactions[i].id, 
-                   current->transactions[i].details);
+                   current->transactions[i]->id, 
+                   current->transactions[i]->details);
         }
-        printf("Previous Block Hash: %s\n", current->previous_block_hash);
-        printf("Block Hash: %s\n", current->block_hash);
-        printf("Nonce: %d\n\n", current->nonce);
+        hash_to_hex(current->transactions_root, hex);
+        printf("Transactions Root: %s\n", hex);
+        hash_to_hex(current->previous_block_hash, hex);
+        printf("Previous Block Hash: %s\n", hex);
+        hash_to_hex(current->block_hash, hex);
+        printf("Block Hash: %s\n", hex);
+        printf("Target: 0x%08x (%.1f leading zero bits)\n", current->target, target_difficulty(current->target));
+        printf("Nonce: %u\n\n", current->nonce);
         current = current->next;
     }
+    printf("Memory: %.1f KB reserved, %.1f KB used by blocks and transactions.\n",
+           atomic_load_explicit(&blockchain->memory_reserved, memory_order_relaxed) / 1024.0,
+           atomic_load_explicit(&blockchain->memory_used, memory_order_relaxed) / 1024.0);
+}
+
+// Display every transaction of one item, oldest first
+// Costs O(k) in the item's history: positions come from the provenance index
+// and blocks are found by index.
+void display_item_history(Blockchain* blockchain, int id) {
+    pthread_mutex_lock(&blockchain->index_lock);
+    const ItemHistory* history = provenance_index_lookup(&blockchain->provenance, id);
+    if (history == NULL) {
+        pthread_mutex_unlock(&blockchain->index_lock);
+        printf("No mined transactions for item %d.\n", id);
+        return;
+    }
+    printf("History of item %d (%d transactions):\n", id, history->count);
+    for (int i = 0; i < history->count; i++) {
+        const Block* block = blockchain->blocks[history->positions[i].block];
+        const Transaction* transaction = block->transactions[history->positions[i].slot];
+        printf("  Block %d, transaction %d, time %ld: %s\n", block->index, history->positions[i].slot,
+               block->creation_time, transaction->details);
+    }
+    pthread_mutex_unlock(&blockchain->index_lock);
 }
 
 // Clear the input buffer to avoid issues with fgets
@@ -171,20 +1153,460 @@ int show_menu(bool initialized, bool has_pending) {
         printf("4. Show blockchain\n");
     }
     printf("5. Exit\n");
+    printf("6. Show metrics\n");
+    if (initialized) {
+        printf("7. Show item history\n");
+    }
     printf("Enter your choice: ");
     scanf("%d", &option);
     clear_input_buffer();
     return option;
 }
 
+// Mine blocks into a new block file at path for the self-test
+// Block i holds a transaction of item 1 and one of item i + 2, both "step i".
+// Returns 0 on success, -1 if the file cannot be created.
+static int self_test_write_blocks(const char* path, int blocks) {
+    char index_path[PATH_MAX];
+    BlockFile file;
+    snprintf(index_path, sizeof(index_path), "%s.index", path);
+    remove(path);
+    remove(index_path);
+    if (block_file_open(&file, path, 0) != 0) {
+        return -1;
+    }
+    Blockchain chain = {.file = &file, .mining_threads = 1, .target = target_for_bits(4)};
+    initialize_blockchain(&chain);
+    for (int i = 0; i < blocks; i++) {
+        char details[32];
+        snprintf(details, sizeof(details), "step %d", i);
+        append_transaction(&chain, 1, details);
+        append_transaction(&chain, i + 2, details);
+        insert_block(&chain, chain.pending_block, NULL);
+        new_pending_block(&chain);
+    }
+    free_blockchain(&chain);
+    block_file_close(&file);
+    return 0;
+}
+
+// Get the size of a file, or -1 if it does not exist
+static long long self_test_file_size(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? (long long)info.st_size : -1;
+}
+
+// Reopen a self-test block file and load it; true if it opens with blocks blocks at the given offsets
+// offsets may be NULL. The chain's item history for item 1 must list one
+// transaction per block, oldest first, and the chain must validate.
+static bool self_test_reload(const char* path, int blocks, const uint64_t* offsets) {
+    BlockFile file;
+    if (block_file_open(&file, path, 0) != 0) {
+        return false;
+    }
+    bool ok = block_file_count(&file) == (size_t)blocks;
+    for (int i = 0; ok && offsets != NULL && i < blocks; i++) {
+        ok = file.index->offsets[i] == offsets[i];
+    }
+    Blockchain chain = {.file = &file, .mining_threads = 1, .target = target_for_bits(4)};
+    initialize_blockchain(&chain);
+    ValidationResult validation;
+    ok = ok && chain.block_count == blocks && validate_blockchain(&chain, 1, &validation);
+
+    // display_item_history walks these positions: block order, then slot
+    const ItemHistory* history = provenance_index_lookup(&chain.provenance, 1);
+    ok = ok && history != NULL && history->count == blocks;
+    for (int i = 0; ok && i < blocks; i++) {
+        char details[32];
+        snprintf(details, sizeof(details), "step %d", i);
+        const Block* block = chain.blocks[history->positions[i].block];
+        ok = block->index == i && history->positions[i].slot == 0 &&
+             strcmp(block->transactions[history->positions[i].slot]->details, details) == 0;
+    }
+    history = provenance_index_lookup(&chain.provenance, blocks + 1);
+    ok = ok && (blocks == 0 || (history != NULL && history->count == 1 && history->positions[0].block == blocks - 1 &&
+                                history->positions[0].slot == 1));
+    free_blockchain(&chain);
+    block_file_close(&file);
+    return ok;
+}
+
+// Check that the block file survives reopening and only ever drops a torn tail
+// Returns the number of failed checks.
+static int self_test_block_file(void) {
+    const char* path = "self_test_blocks.dat";
+    char index_path[PATH_MAX];
+    BlockFile file;
+    uint64_t offsets[3];
+    int checks = 0, failures = 0;
+    snprintf(index_path, sizeof(index_path), "%s.index", path);
+
+    // Blocks, their offsets and the item history come back after a reopen
+    checks++;
+    if (self_test_write_blocks(path, 3) != 0 || block_file_open(&file, path, 0) != 0) {
+        printf("file   cannot create '%s'\n", path);
+        return 1;
+    }
+    memcpy(offsets, file.index->offsets, sizeof(offsets));
+    block_file_close(&file);
+    long long size = self_test_file_size(path);
+    failures += !self_test_reload(path, 3, offsets);
+
+    // An index behind the block file (a crash between the two writes) or with wrong offsets is rebuilt
+    checks++;
+    uint64_t stale_count = 1;
+    uint64_t wrong_offset = offsets[1] + 8;
+    int fd = open(index_path, O_WRONLY);
+    bool written = fd >= 0 && pwrite(fd, &stale_count, sizeof(uint64_t), offsetof(BlockIndex, count)) == sizeof(uint64_t);
+    if (fd >= 0) {
+        close(fd);
+    }
+    failures += !written || !self_test_reload(path, 3, offsets);
+    checks++;
+    fd = open(index_path, O_WRONLY);
+    written = fd >= 0 && pwrite(fd, &wrong_offset, sizeof(uint64_t), sizeof(BlockIndex) + sizeof(uint64_t)) ==
+                             sizeof(uint64_t);
+    if (fd >= 0) {
+        close(fd);
+    }
+    failures += !written || !self_test_reload(path, 3, offsets);
+
+    // A missing index is rebuilt
+    checks++;
+    failures += remove(index_path) != 0 || !self_test_reload(path, 3, offsets);
+
+    // A record cut short at the end is dropped, and only it
+    checks++;
+    failures += truncate(path, (off_t)(size - 10)) != 0 || !self_test_reload(path, 2, offsets) ||
+                self_test_file_size(path) != (long long)offsets[2];
+
+    // A bad length in a record with valid blocks after it fails the open and truncates nothing
+    checks++;
+    if (self_test_write_blocks(path, 3) != 0) {
+        failures++;
+    } else {
+        uint64_t length = 1ULL << 40;
+        fd = open(path, O_WRONLY);
+        bool damaged = fd >= 0 && pwrite(fd, &length, sizeof(length), (off_t)offsets[1]) == (ssize_t)sizeof(length);
+        if (fd >= 0) {
+            close(fd);
+        }
+        bool opened = block_file_open(&file, path, 0) == 0;
+        if (opened) {
+            block_file_close(&file);
+        }
+        failures += !damaged || opened || self_test_file_size(path) != size;
+    }
+
+    remove(path);
+    remove(index_path);
+    printf("file   %d/%d block file checks passed\n", checks - failures, checks);
+    return failures;
+}
+
+// Check every SHA-256 kernel this CPU supports against OpenSSL, then mine a block with each
+// Returns 0 if every hash matched and every mined block verifies.
+int run_self_test(void) {
+    static const Sha256Kernel kernels[] = {SHA256_KERNEL_SCALAR, SHA256_KERNEL_SSE2, SHA256_KERNEL_AVX2};
+    unsigned char header[BLOCK_HEADER_LENGTH];
+    unsigned char expected[SHA256_DIGEST_LENGTH], actual[SHA256_DIGEST_LENGTH];
+    uint32_t state[8];
+    uint32_t words[16][SHA256_MAX_LANES] __attribute__((aligned(32)));
+    uint32_t digest[8][SHA256_MAX_LANES] __attribute__((aligned(32)));
+    int failures = 0;
+
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        Sha256Kernel kernel = kernels[k];
+        if (!sha256_kernel_supported(kernel)) {
+            printf("%-6s skipped (not supported by this CPU)\n", sha256_kernel_name(kernel));
+            continue;
+        }
+
+        // Random headers and nonces, every lane compared with a one-shot OpenSSL hash
+        int checked = 0, mismatches = 0;
+        srand(1);
+        for (int round = 0; round < 256; round++) {
+            for (int i = 0; i < BLOCK_HEADER_LENGTH; i++) {
+                header[i] = (unsigned char)(rand() & 0xff);
+            }
+            header_midstate(header, state);
+            header_tail_words(header, words);
+            uint32_t nonces[SHA256_MAX_LANES];
+            for (int lane = 0; lane < SHA256_MAX_LANES; lane++) {
+                nonces[lane] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+                words[NONCE_WORD][lane] = __builtin_bswap32(nonces[lane]);
+            }
+            sha256_compress_lanes(kernel, state, words, digest);
+            for (int lane = 0; lane < SHA256_MAX_LANES; lane++) {
+                put_little_endian(header + BLOCK_HEADER_LENGTH - 4, nonces[lane], 4);
+                SHA256(header, BLOCK_HEADER_LENGTH, expected);
+                lane_digest(digest, lane, actual);
+                mismatches += memcmp(expected, actual, SHA256_DIGEST_LENGTH) != 0;
+                checked++;
+            }
+        }
+
+        // Mine a block end to end and re-check it the slow way
+        Blockchain chain = {.hash_kernel = kernel};
+        initialize_blockchain(&chain);
+        Block* block = chain.pending_block;
+        append_transaction(&chain, (int)k, "self-test pallet");
+        block->creation_time = 1700000000 + (time_t)k;
+        mine_new_block(block, 2, kernel, NULL);
+        unsigned char minimum[SHA256_DIGEST_LENGTH];
+        target_from_compact(block->target, minimum);
+        bool mined = check_block(block, 0, minimum) == NULL;
+        free_blockchain(&chain);
+
+        printf("%-6s %d/%d hashes match OpenSSL, mined block %s\n", sha256_kernel_name(kernel), checked - mismatches,
+               checked, mined ? "verifies" : "DOES NOT VERIFY");
+        failures += mismatches + !mined;
+    }
+
+    // Targets for whole bits must be exact powers of two and round-trip through the compact form
+    int bad_targets = 0;
+    for (int bits = 1; bits < 256; bits++) {
+        unsigned char target[SHA256_DIGEST_LENGTH], easy[SHA256_DIGEST_LENGTH] = {0}, hard[SHA256_DIGEST_LENGTH];
+        uint32_t compact = target_for_bits(bits);
+        target_from_compact(compact, target);
+        easy[(bits - 1) / 8] = (unsigned char)(0x80 >> ((bits - 1) % 8)); // Only bits - 1 leading zeros
+        memset(hard, 0xff, sizeof(hard)); // Largest hash with bits leading zeros
+        memset(hard, 0, (size_t)bits / 8);
+        if (bits % 8 != 0) {
+            hard[bits / 8] = (unsigned char)(0xff >> (bits % 8));
+        }
+        bad_targets += target_to_compact(target) != compact || target_difficulty(compact) != bits ||
+                       meets_target(easy, target) || !meets_target(hard, target);
+    }
+    printf("target %d/255 leading-zero-bit targets exact\n", 255 - bad_targets);
+    failures += bad_targets;
+
+    // A block mined at an easier target than the chain requires fails validation
+    Blockchain easy = {.mining_threads = 1, .target = target_for_bits(2)};
+    ValidationResult validation;
+    initialize_blockchain(&easy);
+    append_transaction(&easy, 1, "easy pallet");
+    insert_block(&easy, easy.pending_block, NULL);
+    new_pending_block(&easy);
+    bool accepted = validate_blockchain(&easy, 1, NULL);
+    easy.target = target_for_bits(8);
+    bool rejected = !validate_blockchain(&easy, 1, &validation) && validation.first_invalid == 0;
+    free_blockchain(&easy);
+    printf("target easy block %s at its own target, %s at a harder one\n", accepted ? "accepted" : "REJECTED",
+           rejected ? "rejected" : "ACCEPTED");
+    failures += !accepted || !rejected;
+
+    // A parallel batch must produce the same signatures and root as appending one at a time
+    Blockchain single = {.mining_threads = 1}, batched = {.mining_threads = 4};
+    static TransactionInput inputs[3000];
+    static char details[3000][32];
+    initialize_blockchain(&single);
+    initialize_blockchain(&batched);
+    for (int i = 0; i < 3000; i++) {
+        snprintf(details[i], sizeof(details[i]), "pallet %d", i * 7);
+        inputs[i].id = i - 1500;
+        inputs[i].details = details[i];
+        append_transaction(&single, inputs[i].id, inputs[i].details);
+    }
+    int added = append_transactions(&batched, inputs, 1000);
+    added += append_transactions(&batched, inputs + 1000, 2000);
+    bool same = added == 3000 && memcmp(single.pending_block->transactions_root, batched.pending_block->transactions_root,
+                                        SHA256_DIGEST_LENGTH) == 0;
+    for (int i = 0; same && i < 3000; i++) {
+        same = memcmp(single.pending_block->transactions[i]->hash_signature,
+                      batched.pending_block->transactions[i]->hash_signature, SHA256_DIGEST_LENGTH) == 0;
+    }
+    free_blockchain(&single);
+    free_blockchain(&batched);
+    printf("batch  %d/3000 transactions signed in parallel, %s\n", added, same ? "root matches" : "ROOT DIFFERS");
+    failures += !same;
+    failures += self_test_block_file();
+
+    printf("Self-test %s.\n", failures == 0 ? "passed" : "failed");
+    return failures == 0 ? 0 : 1;
+}
+
+// Parse a target given as up to 64 hex digits (optionally prefixed with 0x) into compact form
+// Returns false if it is not hex or is zero.
+static bool parse_target(const char* text, uint32_t* compact) {
+    unsigned char target[SHA256_DIGEST_LENGTH] = {0};
+    if (text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text += 2;
+    }
+    size_t length = strlen(text);
+    if (length == 0 || length > SHA256_DIGEST_LENGTH * 2 || strspn(text, "0123456789abcdefABCDEF") != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char digit = text[length - 1 - i]; // Least significant digit first
+        int value = digit <= '9' ? digit - '0' : (digit | 0x20) - 'a' + 10;
+        target[SHA256_DIGEST_LENGTH - 1 - i / 2] |= (unsigned char)(value << (4 * (i % 2)));
+    }
+    *compact = target_to_compact(target);
+    return *compact != 0;
+}
+
+// Mine a number of synthetic blocks per difficulty and thread count and print the throughput
+// Difficulties are the given compact target, or BENCHMARK_DIFFICULTIES if it is
+// 0; thread counts double from 1 up to max_threads (0 = one per online CPU).
+// The spread of time per block shows how predictable block times are.
+int run_benchmark(int blocks, int max_threads, Sha256Kernel kernel, uint32_t target) {
+    static const int default_bits[] = BENCHMARK_DIFFICULTIES;
+    uint32_t targets[sizeof(default_bits) / sizeof(default_bits[0])];
+    int target_count = 0;
+    double* seconds = (double*)malloc((size_t)blocks * sizeof(double));
+    Block block;
+
+    if (!seconds) {
+        fprintf(stderr, "Error: Memory allocation failed for the benchmark.\n");
+        exit(1);
+    }
+    if (target != 0) {
+        targets[target_count++] = target;
+    } else {
+        for (size_t i = 0; i < sizeof(default_bits) / sizeof(default_bits[0]); i++) {
+            targets[target_count++] = target_for_bits(default_bits[i]);
+        }
+    }
+    max_threads = worker_threads(max_threads);
+    printf("Mining %d synthetic blocks per row with the %s kernel.\n", blocks,
+           sha256_kernel_name(sha256_select_kernel(kernel)));
+    printf("%8s %8s %14s %14s %14s %16s\n", "bits", "threads", "hashes/sec", "s/block", "stddev s", "nonces/block");
+
+    for (int d = 0; d < target_count; d++) {
+        for (int threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+            unsigned long long attempts = 0;
+            double total = 0, squares = 0;
+            for (int i = 0; i < blocks; i++) {
+                MiningStats stats;
+                memset(&block, 0, sizeof(block));
+                block.index = i;
+                block.creation_time = 1700000000 + i;
+                block.target = targets[d];
+                block.transaction_count = 1;
+                SHA256((const unsigned char*)&i, sizeof(i), block.transactions_root);
+                mine_new_block(&block, threads, kernel, &stats);
+                seconds[i] = stats.seconds;
+                attempts += stats.attempts;
+                total += stats.seconds;
+            }
+            double mean = total / blocks;
+            for (int i = 0; i < blocks; i++) {
+                squares += (seconds[i] - mean) * (seconds[i] - mean);
+            }
+            printf("%8.1f %8d %14.0f %14.4f %14.4f %16.0f\n", target_difficulty(targets[d]), threads,
+                   total > 0 ? attempts / total : 0.0, mean, blocks > 1 ? sqrt(squares / (blocks - 1)) : 0.0,
+                   (double)attempts / blocks);
+            fflush(stdout);
+            if (threads == max_threads) {
+                break;
+            }
+        }
+    }
+    free(seconds);
+    return 0;
+}
+
 // Main function to run the menu-driven command-line interface
-int main() {
-    Blockchain blockchain = {NULL, NULL, false};
+int main(int argc, char* argv[]) {
+    Blockchain blockchain = {.hash_kernel = SHA256_KERNEL_AUTO,
+                             .max_block_transactions = DEFAULT_BLOCK_TRANSACTIONS,
+                             .max_block_bytes = DEFAULT_BLOCK_BYTES,
+                             .mempool_capacity = DEFAULT_MEMPOOL_CAPACITY};
+    MetricsFormat metrics_format = METRICS_TEXT;
+    BlockFile block_file;
+    const char* block_path = NULL;
+    bool validate_only = false;
+    int benchmark_blocks = 0;
     int user_choice;
-    
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc &&
+            (strcmp(argv[i + 1], "text") == 0 || strcmp(argv[i + 1], "json") == 0)) {
+            metrics_format = strcmp(argv[++i], "json") == 0 ? METRICS_JSON : METRICS_TEXT;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            blockchain.mining_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            blockchain.hash_kernel = strcmp(name, "scalar") == 0 ? SHA256_KERNEL_SCALAR
+                                   : strcmp(name, "sse2") == 0   ? SHA256_KERNEL_SSE2
+                                   : strcmp(name, "avx2") == 0   ? SHA256_KERNEL_AVX2
+                                                                 : SHA256_KERNEL_AUTO;
+        } else if (strcmp(argv[i], "--block-transactions") == 0 && i + 1 < argc) {
+            blockchain.max_block_transactions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--block-bytes") == 0 && i + 1 < argc) {
+            blockchain.max_block_bytes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mempool") == 0 && i + 1 < argc) {
+            blockchain.mempool_capacity = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--auto-mine") == 0) {
+            blockchain.auto_mine = true;
+        } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            block_path = argv[++i];
+        } else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 1 &&
+                   atoi(argv[i + 1]) <= 255) {
+            blockchain.target = target_for_bits(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc && parse_target(argv[i + 1], &blockchain.target)) {
+            i++;
+        } else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            benchmark_blocks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--validate") == 0) {
+            validate_only = true;
+        } else if (strcmp(argv[i], "--self-test") == 0) {
+            return run_self_test();
+        } else {
+            printf("Usage: %s [--file <path>] [--threads <n>] [--kernel auto|scalar|sse2|avx2] [--block-transactions <n>]\n",
+                   argv[0]);
+            printf("       %*s [--block-bytes <n>] [--mempool <n>] [--auto-mine] [--metrics text|json] [--validate]\n",
+                   (int)strlen(argv[0]), "");
+            printf("       %*s [--difficulty <bits> | --target <hex>] [--benchmark <blocks>] [--self-test]\n",
+                   (int)strlen(argv[0]), "");
+            printf("  --file <path>    Keep mined blocks in an append-only file (and its index, <path>.index)\n");
+            printf("  --threads <n>    Worker threads that mine each block (default: one per CPU)\n");
+            printf("  --kernel <name>  SHA-256 kernel for mining (default: auto, the widest the CPU supports)\n");
+            printf("  --block-transactions <n>  Most transactions per block (default: %d, 0 = no limit)\n",
+                   DEFAULT_BLOCK_TRANSACTIONS);
+            printf("  --block-bytes <n>         Most transaction bytes per block (default: %d, 0 = no limit)\n",
+                   DEFAULT_BLOCK_BYTES);
+            printf("  --mempool <n>    Transactions that can wait to be mined (default: %d)\n", DEFAULT_MEMPOOL_CAPACITY);
+            printf("  --auto-mine      Mine in the background whenever transactions are waiting\n");
+            printf("  --difficulty <bits>  Leading zero bits new block hashes need (1-255, default: %d)\n",
+                   DEFAULT_DIFFICULTY_BITS);
+            printf("  --target <hex>   256-bit target new block hashes must be below, instead of --difficulty\n");
+            printf("  --benchmark <n>  Mine n synthetic blocks per difficulty and thread count, print the rates and exit\n");
+            printf("  --validate       Load the blocks of --file, check every block and link, and exit\n");
+            printf("  --self-test      Check the SHA-256 kernels against OpenSSL and exit\n");
+            printf("  --metrics <fmt>  Format of the latency dump printed to stderr on SIGUSR1: text (default) or json\n");
+            return 1;
+        }
+    }
+    if (benchmark_blocks > 0) {
+        return run_benchmark(benchmark_blocks, blockchain.mining_threads, blockchain.hash_kernel, blockchain.target);
+    }
+    if (block_path != NULL) {
+        if (block_file_open(&block_file, block_path, validate_only) != 0) { // A validator never repairs
+            return 1;
+        }
+        blockchain.file = &block_file;
+    }
+    if (validate_only) {
+        ValidationResult validation;
+        if (block_path == NULL) {
+            printf("--validate needs a block file (--file <path>).\n");
+            return 1;
+        }
+        initialize_blockchain(&blockchain);
+        printf("Loaded %d blocks from '%s'.\n", blockchain.block_count, block_path);
+        validate_blockchain(&blockchain, blockchain.mining_threads, &validation);
+        report_validation(&validation);
+        free_blockchain(&blockchain);
+        block_file_close(&block_file);
+        return validation.valid ? 0 : 1;
+    }
+    metrics_dump_on_signal(SIGUSR1, stderr, metrics_format, metric_names, METRIC_COUNT);
+
     while (true) {
-        user_choice = show_menu(blockchain.initialized, 
-                                 blockchain.pending_block && blockchain.pending_block->transaction_count > 0);
+        user_choice = show_menu(blockchain.initialized,
+                                 blockchain.initialized && pending_transactions(&blockchain) > 0);
         
         switch (user_choice) {
             case 1:
@@ -193,6 +1615,17 @@ int main() {
                 } else {
                     initialize_blockchain(&blockchain);
                     printf("Blockchain successfully initialized.\n");
+                    if (blockchain.file != NULL) {
+                        ValidationResult validation;
+                        printf("Loaded %d blocks from '%s'.\n", blockchain.block_count, block_path);
+                        validate_blockchain(&blockchain, blockchain.mining_threads, &validation);
+                        report_validation(&validation);
+                        if (!validation.valid) {
+                            printf("Mining is disabled: new blocks would extend an invalid chain.\n");
+                            break;
+                        }
+                    }
+                    start_miner(&blockchain);
                 }
                 break;
             
@@ -201,6 +1634,10 @@ int main() {
                     printf("Please initialize the blockchain first.\n");
                     break;
                 }
+                if (!blockchain.miner_running) {
+                    printf("Mining is disabled because the loaded chain is invalid.\n");
+                    break;
+                }
                 int item_id;
                 char details[256];
                 printf("Enter item ID: ");
@@ -210,10 +1647,10 @@ int main() {
                 fgets(details, sizeof(details), stdin);
                 details[strcspn(details, "\n")] = 0; // Remove trailing newline
                 
-                if (append_transaction(blockchain.pending_block, item_id, details)) {
-                    printf("Transaction successfully added to pending block.\n");
+                if (submit_transaction(&blockchain, item_id, details)) {
+                    printf("Transaction queued in the mempool (%zu waiting).\n", pending_transactions(&blockchain));
                 } else {
-                    printf("Unable to add transaction. The pending block may be full.\n");
+                    printf("Unable to add transaction. The mempool is full or it exceeds the block size limit.\n");
                 }
                 break;
             
@@ -222,20 +1659,16 @@ int main() {
                     printf("Please initialize the blockchain first.\n");
                     break;
                 }
-                if (!blockchain.pending_block || blockchain.pending_block->transaction_count == 0) {
-                    printf("No pending transactions available for mining.\n");
+                if (!blockchain.miner_running) {
+                    printf("Mining is disabled because the loaded chain is invalid.\n");
                     break;
                 }
-                insert_block(&blockchain, blockchain.pending_block);
-                printf("New block mined and added to the blockchain.\n");
-                
-                // Allocate a new pending block
-                blockchain.pending_block = (Block*)malloc(sizeof(Block));
-                if (!blockchain.pending_block) {
-                    fprintf(stderr, "Error: Unable to allocate memory for new pending block.\n");
-                    exit(1);
+                size_t pending = pending_transactions(&blockchain);
+                if (!request_mining(&blockchain)) {
+                    printf("No pending transactions available for mining.\n");
+                    break;
                 }
-                blockchain.pending_block->transaction_count = 0;
+                printf("Mining %zu pending transactions in the background.\n", pending);
                 break;
             
             case 4:
@@ -247,8 +1680,36 @@ int main() {
                 break;
             
             case 5:
+                if (blockchain.initialized) {
+                    stop_miner(&blockchain); // Requested blocks are finished first
+                    if (pending_transactions(&blockchain) > 0) {
+                        printf("%zu pending transactions were not mined and are discarded.\n",
+                               pending_transactions(&blockchain));
+                    }
+                }
                 printf("Exiting the program. Goodbye!\n");
+                if (blockchain.initialized) {
+                    free_blockchain(&blockchain);
+                }
+                if (blockchain.file != NULL) {
+                    block_file_close(blockchain.file);
+                }
                 exit(0);
+
+            case 6:
+                metrics_dump(stdout, METRICS_TEXT, metric_names, METRIC_COUNT);
+                break;
+
+            case 7:
+                if (!blockchain.initialized) {
+                    printf("Please initialize the blockchain first.\n");
+                    break;
+                }
+                printf("Enter item ID: ");
+                scanf("%d", &item_id);
+                clear_input_buffer();
+                display_item_history(&blockchain, item_id);
+                break;
             
             default:
                 printf("Invalid option. Please try again.\n");
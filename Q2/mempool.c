@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "mempool.h"
+
+// Each cell's sequence number tells producers and consumers whose turn it is:
+// it equals the position a producer may fill, then position + 1 once filled,
+// then position + capacity once consumed (ready for the next lap). Claiming a
+// position is a single compare-and-swap, so neither side ever takes a lock.
+
+// Function to initialize an empty mempool holding at least capacity transactions
+void mempool_init(Mempool* mempool, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    mempool->cells = (MempoolCell*)malloc(size * sizeof(MempoolCell));
+    if (!mempool->cells) {
+        fprintf(stderr, "Error: Memory allocation failed for mempool.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&mempool->cells[i].sequence, i);
+    }
+    mempool->mask = size - 1;
+    atomic_init(&mempool->enqueue_position, 0);
+    atomic_init(&mempool->dequeue_position, 0);
+}
+
+// Function to queue a transaction (details are copied)
+// Safe to call from any number of threads. Returns false if the mempool is full.
+bool mempool_push(Mempool* mempool, int id, const char* details) {
+    size_t position = atomic_load_explicit(&mempool->enqueue_position, memory_order_relaxed);
+    MempoolCell* cell;
+    for (;;) {
+        cell = &mempool->cells[position & mempool->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t lag = (intptr_t)sequence - (intptr_t)position;
+        if (lag == 0) {
+            if (atomic_compare_exchange_weak_explicit(&mempool->enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (lag < 0) {
+            return false; // The cell still holds a transaction from the previous lap
+        } else {
+            position = atomic_load_explicit(&mempool->enqueue_position, memory_order_relaxed);
+        }
+    }
+
+    cell->entry.id = id;
+    cell->entry.details = strdup(details);
+    if (!cell->entry.details) {
+        fprintf(stderr, "Error: Memory allocation failed for mempool entry.\n");
+        exit(1);
+    }
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    return true;
+}
+
+// Function to take the oldest transaction; the caller then owns entry->details
+// Safe to call from any number of threads. Returns false if the mempool is empty.
+bool mempool_pop(Mempool* mempool, MempoolEntry* entry) {
+    size_t position = atomic_load_explicit(&mempool->dequeue_position, memory_order_relaxed);
+    MempoolCell* cell;
+    for (;;) {
+        cell = &mempool->cells[position & mempool->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t lag = (intptr_t)sequence - (intptr_t)(position + 1);
+        if (lag == 0) {
+            if (atomic_compare_exchange_weak_explicit(&mempool->dequeue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (lag < 0) {
+            return false; // Not filled yet
+        } else {
+            position = atomic_load_explicit(&mempool->dequeue_position, memory_order_relaxed);
+        }
+    }
+
+    *entry = cell->entry;
+    atomic_store_explicit(&cell->sequence, position + mempool->mask + 1, memory_order_release);
+    return true;
+}
+
+// Function to get roughly how many transactions are waiting (exact when nothing is in flight)
+size_t mempool_size(Mempool* mempool) {
+    size_t dequeued = atomic_load_explicit(&mempool->dequeue_position, memory_order_relaxed);
+    size_t enqueued = atomic_load_explicit(&mempool->enqueue_position, memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+// Function to free the mempool and any transactions still queued
+void mempool_destroy(Mempool* mempool) {
+    MempoolEntry entry;
+    while (mempool_pop(mempool, &entry)) {
+        free(entry.details);
+    }
+    free(mempool->cells);
+    mempool->cells = NULL;
+}
@@ -0,0 +1,39 @@
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MEMPOOL_CACHE_LINE 64
+
+// A transaction waiting to be mined
+typedef struct {
+    int id; // Item ID
+    char* details; // Heap copy of the description, owned by whoever holds the entry
+} MempoolEntry;
+
+// One slot of the ring; sequence says whose turn it is (see mempool.c)
+typedef struct {
+    _Atomic size_t sequence;
+    MempoolEntry entry;
+} MempoolCell;
+
+// Bounded lock-free multi-producer multi-consumer queue of pending transactions
+// The two positions live on separate cache lines so producers and consumers do
+// not invalidate each other's line on every operation.
+typedef struct {
+    MempoolCell* cells; // Ring of capacity cells
+    size_t mask; // capacity - 1 (capacity is a power of two)
+    _Alignas(MEMPOOL_CACHE_LINE) _Atomic size_t enqueue_position; // Next cell producers claim
+    _Alignas(MEMPOOL_CACHE_LINE) _Atomic size_t dequeue_position; // Next cell consumers claim
+} Mempool;
+
+// Function prototypes
+void mempool_init(Mempool* mempool, size_t capacity);
+bool mempool_push(Mempool* mempool, int id, const char* details);
+bool mempool_pop(Mempool* mempool, MempoolEntry* entry);
+size_t mempool_size(Mempool* mempool);
+void mempool_destroy(Mempool* mempool);
+
+#endif
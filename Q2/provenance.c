@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "provenance.h"
+
+#define PROVENANCE_INDEX_MIN_CAPACITY 256
+
+// Hash an item ID (Fibonacci hashing spreads consecutive IDs across the table)
+static size_t hash_id(int id) {
+    return (size_t)(((uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// Find the slot holding id, or the empty slot where it would go
+static size_t provenance_index_probe(const ProvenanceIndex* index, int id) {
+    size_t mask = index->capacity - 1;
+    size_t slot = hash_id(id) & mask;
+    while (index->entries[slot].positions != NULL && index->entries[slot].id != id) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Grow the item table and re-insert every item
+static void provenance_index_grow(ProvenanceIndex* index) {
+    ItemHistory* old_entries = index->entries;
+    size_t old_capacity = index->capacity;
+    size_t new_capacity = old_capacity ? old_capacity * 2 : PROVENANCE_INDEX_MIN_CAPACITY;
+
+    index->entries = (ItemHistory*)calloc(new_capacity, sizeof(ItemHistory));
+    if (!index->entries) {
+        fprintf(stderr, "Error: Memory allocation failed for provenance index.\n");
+        exit(1);
+    }
+    index->capacity = new_capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].positions != NULL) {
+            index->entries[provenance_index_probe(index, old_entries[i].id)] = old_entries[i];
+        }
+    }
+    free(old_entries);
+}
+
+// Function to initialize an empty provenance index
+void provenance_index_init(ProvenanceIndex* index) {
+    index->entries = NULL;
+    index->capacity = 0;
+    index->used = 0;
+}
+
+// Function to release every item's history
+void provenance_index_free(ProvenanceIndex* index) {
+    for (size_t i = 0; i < index->capacity; i++) {
+        free(index->entries[i].positions);
+    }
+    free(index->entries);
+    provenance_index_init(index);
+}
+
+// Function to record that slot of block holds a transaction for item id
+// Blocks are indexed in chain order, so each history stays oldest first.
+void provenance_index_add(ProvenanceIndex* index, int id, int block, int slot) {
+    if ((index->used + 1) * 2 > index->capacity) {
+        provenance_index_grow(index);
+    }
+    ItemHistory* history = &index->entries[provenance_index_probe(index, id)];
+    if (history->positions == NULL || history->count == history->capacity) {
+        int capacity = history->capacity ? history->capacity * 2 : 4;
+        ItemPosition* positions = (ItemPosition*)realloc(history->positions, capacity * sizeof(ItemPosition));
+        if (!positions) {
+            fprintf(stderr, "Error: Memory allocation failed for item history.\n");
+            exit(1);
+        }
+        if (history->positions == NULL) {
+            history->id = id;
+            index->used++;
+        }
+        history->positions = positions;
+        history->capacity = capacity;
+    }
+    history->positions[history->count].block = block;
+    history->positions[history->count].slot = slot;
+    history->count++;
+}
+
+// Function to look up an item's history (NULL if it has no transactions)
+const ItemHistory* provenance_index_lookup(const ProvenanceIndex* index, int id) {
+    if (index->capacity == 0) {
+        return NULL;
+    }
+    const ItemHistory* history = &index->entries[provenance_index_probe(index, id)];
+    return history->positions != NULL ? history : NULL;
+}
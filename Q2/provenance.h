@@ -0,0 +1,33 @@
+#ifndef PROVENANCE_H
+#define PROVENANCE_H
+
+#include <stddef.h>
+
+// Where one transaction sits in the chain
+typedef struct {
+    int block; // Block index
+    int slot; // Position in the block's transactions
+} ItemPosition;
+
+// Every transaction of one item, oldest first
+typedef struct {
+    int id; // Item ID
+    ItemPosition* positions; // NULL for an empty slot of the table
+    int count; // Positions in use
+    int capacity; // Allocated positions
+} ItemHistory;
+
+// Index from item ID to the positions of its transactions
+typedef struct {
+    ItemHistory* entries; // Open-addressing table of items
+    size_t capacity; // Number of slots (power of two)
+    size_t used; // Number of distinct items
+} ProvenanceIndex;
+
+// Function prototypes
+void provenance_index_init(ProvenanceIndex* index);
+void provenance_index_free(ProvenanceIndex* index);
+void provenance_index_add(ProvenanceIndex* index, int id, int block, int slot);
+const ItemHistory* provenance_index_lookup(const ProvenanceIndex* index, int id);
+
+#endif
@@ -0,0 +1,241 @@
+#include "sha256_lanes.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHA256_LANES_X86 1
+#else
+#define SHA256_LANES_X86 0
+#endif
+
+// SHA-256 round constants
+static const uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// Compress one lane's 64-byte block (as 16 big-endian words) into a copy of state
+static void compress_scalar(const uint32_t state[8], const uint32_t words[16][SHA256_MAX_LANES], int lane,
+                            uint32_t digest[8][SHA256_MAX_LANES]) {
+    uint32_t w[16];
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = words[i][lane];
+    }
+#pragma GCC unroll 64
+    for (int i = 0; i < 64; i++) {
+        if (i >= 16) {
+            uint32_t w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            w[i & 15] += (ROTR32(w15, 7) ^ ROTR32(w15, 18) ^ (w15 >> 3)) + w[(i - 7) & 15] +
+                         (ROTR32(w2, 17) ^ ROTR32(w2, 19) ^ (w2 >> 10));
+        }
+        uint32_t t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) +
+                      round_constants[i] + w[i & 15];
+        uint32_t t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    digest[0][lane] = state[0] + a;
+    digest[1][lane] = state[1] + b;
+    digest[2][lane] = state[2] + c;
+    digest[3][lane] = state[3] + d;
+    digest[4][lane] = state[4] + e;
+    digest[5][lane] = state[5] + f;
+    digest[6][lane] = state[6] + g;
+    digest[7][lane] = state[7] + h;
+}
+
+#if SHA256_LANES_X86
+// The vector kernels run the scalar algorithm with each 32-bit word widened to
+// one word per lane; Ch and Maj use the and-not / xor forms x86 has instructions for.
+
+#define ROTR128(x, n) _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
+
+// Compress lanes first..first+3 with SSE2 (baseline on x86-64)
+__attribute__((target("sse2")))
+static void compress_sse2(const uint32_t state[8], const uint32_t words[16][SHA256_MAX_LANES], int first,
+                          uint32_t digest[8][SHA256_MAX_LANES]) {
+    __m128i w[16], s[8];
+    for (int i = 0; i < 16; i++) {
+        w[i] = _mm_loadu_si128((const __m128i*)&words[i][first]);
+    }
+    for (int i = 0; i < 8; i++) {
+        s[i] = _mm_set1_epi32((int)state[i]);
+    }
+    __m128i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+#pragma GCC unroll 64
+    for (int i = 0; i < 64; i++) {
+        if (i >= 16) {
+            __m128i w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            __m128i s0 = _mm_xor_si128(_mm_xor_si128(ROTR128(w15, 7), ROTR128(w15, 18)), _mm_srli_epi32(w15, 3));
+            __m128i s1 = _mm_xor_si128(_mm_xor_si128(ROTR128(w2, 17), ROTR128(w2, 19)), _mm_srli_epi32(w2, 10));
+            w[i & 15] = _mm_add_epi32(_mm_add_epi32(w[i & 15], s0), _mm_add_epi32(w[(i - 7) & 15], s1));
+        }
+        __m128i sum1 = _mm_xor_si128(_mm_xor_si128(ROTR128(e, 6), ROTR128(e, 11)), ROTR128(e, 25));
+        __m128i choose = _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g));
+        __m128i t1 = _mm_add_epi32(_mm_add_epi32(h, sum1),
+                                   _mm_add_epi32(_mm_add_epi32(choose, _mm_set1_epi32((int)round_constants[i])),
+                                                 w[i & 15]));
+        __m128i sum0 = _mm_xor_si128(_mm_xor_si128(ROTR128(a, 2), ROTR128(a, 13)), ROTR128(a, 22));
+        __m128i majority = _mm_xor_si128(_mm_and_si128(a, b), _mm_and_si128(c, _mm_xor_si128(a, b)));
+        __m128i t2 = _mm_add_epi32(sum0, majority);
+        h = g;
+        g = f;
+        f = e;
+        e = _mm_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm_add_epi32(t1, t2);
+    }
+    __m128i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++) {
+        _mm_storeu_si128((__m128i*)&digest[i][first], _mm_add_epi32(s[i], out[i]));
+    }
+}
+
+#define ROTR256(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+// Compress all eight lanes with AVX2
+__attribute__((target("avx2")))
+static void compress_avx2(const uint32_t state[8], const uint32_t words[16][SHA256_MAX_LANES],
+                          uint32_t digest[8][SHA256_MAX_LANES]) {
+    __m256i w[16], s[8];
+    for (int i = 0; i < 16; i++) {
+        w[i] = _mm256_loadu_si256((const __m256i*)words[i]);
+    }
+    for (int i = 0; i < 8; i++) {
+        s[i] = _mm256_set1_epi32((int)state[i]);
+    }
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+#pragma GCC unroll 64
+    for (int i = 0; i < 64; i++) {
+        if (i >= 16) {
+            __m256i w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(w15, 7), ROTR256(w15, 18)),
+                                          _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(w2, 17), ROTR256(w2, 19)),
+                                          _mm256_srli_epi32(w2, 10));
+            w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+        }
+        __m256i sum1 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(e, 6), ROTR256(e, 11)), ROTR256(e, 25));
+        __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(
+            _mm256_add_epi32(h, sum1),
+            _mm256_add_epi32(_mm256_add_epi32(choose, _mm256_set1_epi32((int)round_constants[i])), w[i & 15]));
+        __m256i sum0 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(a, 2), ROTR256(a, 13)), ROTR256(a, 22));
+        __m256i majority = _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_xor_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(sum0, majority);
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+    __m256i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++) {
+        _mm256_storeu_si256((__m256i*)digest[i], _mm256_add_epi32(s[i], out[i]));
+    }
+}
+#endif
+
+// Function to check whether this CPU can run a kernel
+int sha256_kernel_supported(Sha256Kernel kernel) {
+    switch (kernel) {
+        case SHA256_KERNEL_AUTO:
+        case SHA256_KERNEL_SCALAR:
+            return 1;
+#if SHA256_LANES_X86
+        case SHA256_KERNEL_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case SHA256_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return 0;
+    }
+}
+
+// Function to resolve a requested kernel to one this CPU runs
+// AUTO picks the widest supported kernel; an unsupported request falls back the same way.
+Sha256Kernel sha256_select_kernel(Sha256Kernel requested) {
+    if (requested != SHA256_KERNEL_AUTO && sha256_kernel_supported(requested)) {
+        return requested;
+    }
+    if (sha256_kernel_supported(SHA256_KERNEL_AVX2)) {
+        return SHA256_KERNEL_AVX2;
+    }
+    if (sha256_kernel_supported(SHA256_KERNEL_SSE2)) {
+        return SHA256_KERNEL_SSE2;
+    }
+    return SHA256_KERNEL_SCALAR;
+}
+
+// Function to get how many lanes a kernel hashes per call
+// Every kernel accepts SHA256_MAX_LANES lanes; this is the width it computes at once.
+int sha256_kernel_lanes(Sha256Kernel kernel) {
+    switch (kernel) {
+        case SHA256_KERNEL_SSE2:
+            return 4;
+        case SHA256_KERNEL_AVX2:
+            return 8;
+        default:
+            return 1;
+    }
+}
+
+// Function to get a kernel's display name
+const char* sha256_kernel_name(Sha256Kernel kernel) {
+    switch (kernel) {
+        case SHA256_KERNEL_SCALAR:
+            return "scalar";
+        case SHA256_KERNEL_SSE2:
+            return "sse2";
+        case SHA256_KERNEL_AVX2:
+            return "avx2";
+        default:
+            return "auto";
+    }
+}
+
+// Function to run one SHA-256 compression on each of SHA256_MAX_LANES blocks from a shared state
+// words[i][lane] is word i (big-endian, as SHA-256 reads it) of lane's block;
+// digest[i][lane] receives word i of the resulting state. kernel must be
+// supported (see sha256_select_kernel).
+void sha256_compress_lanes(Sha256Kernel kernel, const uint32_t state[8], const uint32_t words[16][SHA256_MAX_LANES],
+                           uint32_t digest[8][SHA256_MAX_LANES]) {
+#if SHA256_LANES_X86
+    if (kernel == SHA256_KERNEL_AVX2) {
+        compress_avx2(state, words, digest);
+        return;
+    }
+    if (kernel == SHA256_KERNEL_SSE2) {
+        compress_sse2(state, words, 0, digest);
+        compress_sse2(state, words, 4, digest);
+        return;
+    }
+#endif
+    for (int lane = 0; lane < SHA256_MAX_LANES; lane++) {
+        compress_scalar(state, words, lane, digest);
+    }
+}
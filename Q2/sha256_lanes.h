@@ -0,0 +1,24 @@
+#ifndef SHA256_LANES_H
+#define SHA256_LANES_H
+
+#include <stdint.h>
+
+#define SHA256_MAX_LANES 8 // Widest kernel: one 256-bit register of 32-bit words
+
+// Multi-buffer SHA-256 compression kernels
+typedef enum {
+    SHA256_KERNEL_AUTO, // Widest kernel the CPU supports
+    SHA256_KERNEL_SCALAR, // Portable C, one lane at a time
+    SHA256_KERNEL_SSE2, // 4 lanes per call
+    SHA256_KERNEL_AVX2 // 8 lanes per call
+} Sha256Kernel;
+
+// Function prototypes
+Sha256Kernel sha256_select_kernel(Sha256Kernel requested);
+int sha256_kernel_supported(Sha256Kernel kernel);
+int sha256_kernel_lanes(Sha256Kernel kernel);
+const char* sha256_kernel_name(Sha256Kernel kernel);
+void sha256_compress_lanes(Sha256Kernel kernel, const uint32_t state[8], const uint32_t words[16][SHA256_MAX_LANES],
+                           uint32_t digest[8][SHA256_MAX_LANES]);
+
+#endif
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include "metrics.h"
+
+// Histograms owned by one thread; only that thread writes them
+// Threads that exit hand their storage to the next thread that records, so
+// counts survive short-lived workers and memory stays bounded by peak concurrency.
+typedef struct MetricsThread {
+    MetricsHistogram histograms[METRICS_MAX_OPERATIONS];
+    int in_use;                     // Owned by a live thread (guarded by threads_lock)
+    struct MetricsThread* next;
+} MetricsThread;
+
+// Arguments of the signal dumper thread
+typedef struct {
+    int signal_number;
+    FILE* out;
+    MetricsFormat format;
+    const char* const* names;
+    int count;
+} SignalDumper;
+
+static MetricsThread* threads = NULL;   // Every thread storage ever allocated
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static __thread MetricsThread* local = NULL;
+
+// Add to a counter only this thread writes; readers may load it at any time
+static void bump(uint64_t* counter, uint64_t value) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+// Bucket of a latency: exact below 16 ns, then 16 buckets per power of two
+static int bucket_index(uint64_t nanos) {
+    if (nanos < (1u << METRICS_SUB_BUCKET_BITS)) {
+        return (int)nanos;
+    }
+    int exponent = 63 - __builtin_clzll(nanos);
+    if (exponent > METRICS_MAX_EXPONENT) {
+        return METRICS_BUCKETS - 1;
+    }
+    int sub_bucket = (int)(nanos >> (exponent - METRICS_SUB_BUCKET_BITS)) & ((1 << METRICS_SUB_BUCKET_BITS) - 1);
+    return ((exponent - METRICS_SUB_BUCKET_BITS + 1) << METRICS_SUB_BUCKET_BITS) + sub_bucket;
+}
+
+// Largest latency that falls in a bucket
+static uint64_t bucket_upper(int index) {
+    if (index < (1 << METRICS_SUB_BUCKET_BITS)) {
+        return (uint64_t)index;
+    }
+    int exponent = (index >> METRICS_SUB_BUCKET_BITS) + METRICS_SUB_BUCKET_BITS - 1;
+    uint64_t sub_bucket = (uint64_t)(index & ((1 << METRICS_SUB_BUCKET_BITS) - 1));
+    int shift = exponent - METRICS_SUB_BUCKET_BITS;
+    return (((1u << METRICS_SUB_BUCKET_BITS) + sub_bucket) << shift) + ((uint64_t)1 << shift) - 1;
+}
+
+// Release a thread's storage for reuse when it exits
+static void detach_thread(void* storage) {
+    pthread_mutex_lock(&threads_lock);
+    ((MetricsThread*)storage)->in_use = 0;
+    pthread_mutex_unlock(&threads_lock);
+}
+
+static void create_thread_key(void) {
+    pthread_key_create(&thread_key, detach_thread);
+}
+
+// Give the calling thread its histograms, reusing those of an exited thread if possible
+static MetricsThread* attach_thread(void) {
+    pthread_once(&thread_key_once, create_thread_key);
+    pthread_mutex_lock(&threads_lock);
+    MetricsThread* storage = threads;
+    while (storage != NULL && storage->in_use) {
+        storage = storage->next;
+    }
+    if (storage == NULL) {
+        storage = (MetricsThread*)calloc(1, sizeof(MetricsThread));
+        if (!storage) {
+            fprintf(stderr, "Error: Memory allocation failed for metrics.\n");
+            exit(1);
+        }
+        storage->next = threads;
+        threads = storage;
+    }
+    storage->in_use = 1;
+    pthread_mutex_unlock(&threads_lock);
+    pthread_setspecific(thread_key, storage);
+    local = storage;
+    return storage;
+}
+
+// Function to read the monotonic clock in nanoseconds
+uint64_t metrics_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Function to record one call of an operation in the calling thread's histogram
+// Lock-free after a thread's first call.
+void metrics_record(int operation, uint64_t nanos) {
+    if (operation < 0 || operation >= METRICS_MAX_OPERATIONS) {
+        return;
+    }
+    MetricsThread* storage = local != NULL ? local : attach_thread();
+    MetricsHistogram* histogram = &storage->histograms[operation];
+    bump(&histogram->count, 1);
+    bump(&histogram->total_ns, nanos);
+    bump(&histogram->buckets[bucket_index(nanos)], 1);
+    if (nanos > __atomic_load_n(&histogram->max_ns, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&histogram->max_ns, nanos, __ATOMIC_RELAXED);
+    }
+}
+
+// Function to sum an operation's histograms across every thread
+// Calls still being recorded may be partly counted.
+void metrics_collect(int operation, MetricsHistogram* histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+    if (operation < 0 || operation >= METRICS_MAX_OPERATIONS) {
+        return;
+    }
+    pthread_mutex_lock(&threads_lock);
+    for (MetricsThread* storage = threads; storage != NULL; storage = storage->next) {
+        const MetricsHistogram* source = &storage->histograms[operation];
+        histogram->count += __atomic_load_n(&source->count, __ATOMIC_RELAXED);
+        histogram->total_ns += __atomic_load_n(&source->total_ns, __ATOMIC_RELAXED);
+        uint64_t max = __atomic_load_n(&source->max_ns, __ATOMIC_RELAXED);
+        if (max > histogram->max_ns) {
+            histogram->max_ns = max;
+        }
+        for (int i = 0; i < METRICS_BUCKETS; i++) {
+            histogram->buckets[i] += __atomic_load_n(&source->buckets[i], __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&threads_lock);
+}
+
+// Function to estimate the latency below which fraction (0..1] of calls fall
+uint64_t metrics_percentile(const MetricsHistogram* histogram, double fraction) {
+    uint64_t total = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        total += histogram->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(fraction * (double)total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            return upper < histogram->max_ns ? upper : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+// Function to print every named operation's call count and latency distribution
+// names[i] names operation i; operations never recorded are listed with zeros.
+void metrics_dump(FILE* out, MetricsFormat format, const char* const names[], int count) {
+    MetricsHistogram* histogram = (MetricsHistogram*)malloc(sizeof(MetricsHistogram));
+    if (!histogram) {
+        fprintf(stderr, "Error: Memory allocation failed for metrics.\n");
+        exit(1);
+    }
+    if (format == METRICS_JSON) {
+        fprintf(out, "{\"enabled\":%s,\"operations\":[", METRICS_ENABLED ? "true" : "false");
+    } else if (!METRICS_ENABLED) {
+        fprintf(out, "Metrics are not compiled in (rebuild with -DENABLE_METRICS).\n");
+    } else {
+        fprintf(out, "%-20s %10s %11s %11s %11s %11s %12s\n", "operation", "calls", "mean (us)", "p50 (us)",
+                "p90 (us)", "p99 (us)", "max (us)");
+    }
+
+    for (int op = 0; op < count && op < METRICS_MAX_OPERATIONS; op++) {
+        metrics_collect(op, histogram);
+        double mean = histogram->count > 0 ? (double)histogram->total_ns / (double)histogram->count : 0;
+        uint64_t p50 = metrics_percentile(histogram, 0.50), p90 = metrics_percentile(histogram, 0.90);
+        uint64_t p99 = metrics_percentile(histogram, 0.99);
+        if (format == METRICS_JSON) {
+            fprintf(out,
+                    "%s{\"op\":\"%s\",\"calls\":%llu,\"mean_ns\":%.1f,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,"
+                    "\"max_ns\":%llu,\"buckets\":[",
+                    op ? "," : "", names[op], (unsigned long long)histogram->count, mean, (unsigned long long)p50,
+                    (unsigned long long)p90, (unsigned long long)p99, (unsigned long long)histogram->max_ns);
+            int first = 1;
+            for (int i = 0; i < METRICS_BUCKETS; i++) {
+                if (histogram->buckets[i] > 0) {
+                    // [largest latency in the bucket, calls]
+                    fprintf(out, "%s[%llu,%llu]", first ? "" : ",", (unsigned long long)bucket_upper(i),
+                            (unsigned long long)histogram->buckets[i]);
+                    first = 0;
+                }
+            }
+            fprintf(out, "]}");
+        } else if (METRICS_ENABLED) {
+            fprintf(out, "%-20s %10llu %11.2f %11.2f %11.2f %11.2f %12.2f\n", names[op],
+                    (unsigned long long)histogram->count, mean / 1e3, p50 / 1e3, p90 / 1e3, p99 / 1e3,
+                    histogram->max_ns / 1e3);
+        }
+    }
+    if (format == METRICS_JSON) {
+        fprintf(out, "]}\n");
+    }
+    fflush(out);
+    free(histogram);
+}
+
+// Dump metrics each time the signal arrives
+static void* signal_dumper(void* arg) {
+    SignalDumper* dumper = (SignalDumper*)arg;
+    sigset_t signals;
+    int received;
+    sigemptyset(&signals);
+    sigaddset(&signals, dumper->signal_number);
+    for (;;) {
+        if (sigwait(&signals, &received) == 0) {
+            metrics_dump(dumper->out, dumper->format, dumper->names, dumper->count);
+        }
+    }
+    return NULL;
+}
+
+// Function to dump metrics to out whenever signal_number (e.g. SIGUSR1) is received
+// The signal is blocked in the calling thread and waited for by a background
+// thread, so call this before creating other threads: they inherit the mask.
+// Returns 0 on success, -1 on error.
+int metrics_dump_on_signal(int signal_number, FILE* out, MetricsFormat format, const char* const names[], int count) {
+    static SignalDumper dumper;
+    sigset_t signals;
+    pthread_t thread;
+
+    dumper.signal_number = signal_number;
+    dumper.out = out;
+    dumper.format = format;
+    dumper.names = names;
+    dumper.count = count;
+    sigemptyset(&signals);
+    sigaddset(&signals, signal_number);
+    if (pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0 || pthread_create(&thread, NULL, signal_dumper, &dumper) != 0) {
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define METRICS_MAX_OPERATIONS 16
+#define METRICS_SUB_BUCKET_BITS 4   // 16 buckets per power of two: recorded values are within 6.25%
+#define METRICS_MAX_EXPONENT 40     // Latencies up to 2^41 ns (about 36 minutes); longer ones share the last bucket
+#define METRICS_BUCKETS ((METRICS_MAX_EXPONENT - METRICS_SUB_BUCKET_BITS + 2) << METRICS_SUB_BUCKET_BITS)
+
+// Output formats for metrics_dump
+typedef enum {
+    METRICS_TEXT,                   // Aligned table
+    METRICS_JSON                    // One JSON object with every operation and its non-empty buckets
+} MetricsFormat;
+
+// Latency histogram of one operation (HDR-style: log-linear buckets of nanoseconds)
+typedef struct {
+    uint64_t count;                 // Calls recorded
+    uint64_t total_ns;              // Sum of their latencies
+    uint64_t max_ns;                // Slowest call
+    uint64_t buckets[METRICS_BUCKETS];
+} MetricsHistogram;
+
+// Timing hooks for hot paths. Build with -DENABLE_METRICS to record; otherwise
+// they expand to nothing and cost nothing.
+#ifdef ENABLE_METRICS
+#define METRICS_ENABLED 1
+#define METRIC_START(timer) uint64_t timer = metrics_now()
+#define METRIC_STOP(operation, timer) metrics_record((operation), metrics_now() - (timer))
+#else
+#define METRICS_ENABLED 0
+#define METRIC_START(timer) ((void)0)
+#define METRIC_STOP(operation, timer) ((void)0)
+#endif
+
+// Function prototypes
+uint64_t metrics_now(void);
+void metrics_record(int operation, uint64_t nanos);
+void metrics_collect(int operation, MetricsHistogram* histogram);
+uint64_t metrics_percentile(const MetricsHistogram* histogram, double fraction);
+void metrics_dump(FILE* out, MetricsFormat format, const char* const names[], int count);
+int metrics_dump_on_signal(int signal_number, FILE* out, MetricsFormat format, const char* const names[], int count);
+
+#endif